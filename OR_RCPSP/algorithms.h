@@ -3,10 +3,21 @@
 #define ALGORITHMS_RCPSP_H
 
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <exception>
+#include <limits>
+#include <random>
 #include <vector>
 #include <string>
+#include <tuple>
 #include <memory>
+#include <mutex>
+#include "instance.h"
+#include "linear_model.h"
+#include "sgs.h"
 #include "ortools/linear_solver/linear_solver.h"
 
 
@@ -32,6 +43,50 @@ namespace RCPSP // resource-constrained project scheduling problem
 
 	///////////////////////////////////////////////////////////////////////////
 
+	// Options of the underlying solvers and search procedures; every algorithm uses the ones that apply to it
+	struct SolverOptions
+	{
+		std::string mip_solver = "SCIP";	// MPSolver backend of the IP: SCIP, CBC, CP-SAT, GUROBI, CPLEX, ... (as available in OR-Tools)
+		int nb_workers = 0;					// parallel workers of CP-SAT and threads of the MIP solver and the IP model builder, 0 for the default of the solver
+		double relative_gap = -1;			// relative gap at which the search stops, negative for the default of the solver
+		bool presolve = true;
+		std::string parameters;				// solver specific parameters, in the format of the solver (SatParameters text format for CP-SAT)
+		std::string formulation = "aggregated";	// precedence constraints of the IP: "aggregated" or "disaggregated"
+		bool horizon_search = false;		// IP: a sequence of feasibility problems on tightening horizons instead of one optimization
+		unsigned int seed = 0;				// seed of the random number generators of the metaheuristics
+		size_t max_schedules = 0;			// schedules generated by a metaheuristic, 0 for the default of the algorithm
+		bool justify = false;				// double justification of the final schedule and of the schedules of the metaheuristics
+		int beam_width = 0;					// DH: filtered beam search that expands this many nodes per level, 0 for the exact search
+		bool rollouts = false;				// DH: rank the delaying alternatives also by the makespan of an SGS rollout
+		std::string restarts = "none";		// DH: restart policy on the number of nodes, "none", "luby" or "geometric"
+		size_t restart_nodes = 1000;		// DH: nodes of the first run, scaled for the next runs by the restart policy
+		std::string lns_repair = "DH";		// LNS: algorithm that re-optimizes a neighbourhood, "DH" or "CPSAT"
+		int lns_size = 30;					// LNS: activities per neighbourhood at the start, adapted to the repair times
+	};
+
+	// MPSolver for the MIP backend of the options; throws if it is not available
+	std::unique_ptr<operations_research::MPSolver> create_mip_solver(const SolverOptions& options);
+
+	// Apply the options to a MIP solver and its solve parameters; throws if the solver rejects the specific parameters
+	void set_mip_options(operations_research::MPSolver& solver, operations_research::MPSolverParameters& parameters,
+		const SolverOptions& options, Output& output);
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Bounds shared by the algorithms that race in a portfolio: each of them prunes with the best makespan found by any
+	// of them, and all of them stop as soon as the bounds meet
+	struct SharedBounds
+	{
+		std::atomic<int> upper_bound{ std::numeric_limits<int>::max() };
+		std::atomic<int> lower_bound{ 0 };
+		std::atomic<bool> stop{ false }; // set when the bounds meet, also the external limit of CP-SAT
+
+		void improve_upper_bound(int makespan);
+		void improve_lower_bound(int bound);
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
 	// Base class
 	class Algorithm
 	{
@@ -39,8 +94,25 @@ namespace RCPSP // resource-constrained project scheduling problem
 		// output
 		Output _output;
 		bool _verbose;
+		bool _silent = false; // no output at all, e.g. in batch mode
+
+		// limits
+		double _max_computation_time = std::numeric_limits<double>::infinity(); // seconds
+
+		// file to which the IP based algorithms export their model (.lp or .mps), empty for none
+		std::string _model_file;
+
+		SolverOptions _solver_options;
+
+		// bounds of the portfolio the algorithm races in, nullptr if it runs on its own
+		SharedBounds* _shared = nullptr;
+		int shared_upper_bound() const { return _shared ? _shared->upper_bound.load() : std::numeric_limits<int>::max(); }
+		bool shared_stop() const { return _shared && _shared->stop.load(); }
+		void share_upper_bound(int makespan) { if (_shared) _shared->improve_upper_bound(makespan); }
+		void share_lower_bound(int bound) { if (_shared) _shared->improve_lower_bound(bound); }
 
 		// project data
+		Instance _instance; // flat copy of the project data
 		struct Activity
 		{
 			int id;
@@ -57,14 +129,49 @@ namespace RCPSP // resource-constrained project scheduling problem
 		int _upper_bound = std::numeric_limits<int>::max();
 		std::vector<int> _best_activity_finish_times;
 
+		// statistics of the last run
+		int _lower_bound = 0;
+		bool _optimal = false; // true if the best solution was proven to be optimal
+		size_t _nb_nodes = 0;
+		double _root_bound = 0; // bound of the LP relaxation, 0 if the algorithm does not solve one
+		int _justification_saving = 0; // makespan saved by the double justification of the best schedule
+
+		// feasible schedule from a serial schedule generation scheme, returns its makespan
+		int heuristic_schedule(std::vector<int>& start_times) const;
+
+		// precedence feasible activity lists: latest start first, or sampled with a bias towards small latest starts
+		void latest_start_activity_list(std::vector<int>& activity_list) const;
+		void sample_activity_list(std::vector<int>& activity_list, std::mt19937_64& rng) const;
+
+		// maximum of the critical path length and the resource-based bounds
+		int simple_lower_bound() const;
+
 
 
 	public:
 		virtual ~Algorithm() {}
 
-		void read_data(const std::string& filename);
-		void check_solution();
+		void read_data(const std::string& filename, bool use_cache = false);
+		void load_instance(const Instance& instance);
+		bool check_solution();
 		virtual void run(bool verbose) = 0;
+		void justify(); // double justification of the best schedule after run(), if enabled and not proven optimal
+
+		void set_max_time(double time) { _max_computation_time = time; }
+		double max_time() const { return _max_computation_time; }
+		void set_silent(bool silent) { _silent = silent; }
+		void set_model_file(const std::string& filename) { _model_file = filename; }
+		void set_solver_options(const SolverOptions& options) { _solver_options = options; }
+		void set_shared_bounds(SharedBounds* shared) { _shared = shared; }
+
+		int nb_activities() const { return static_cast<int>(_activities.size()); }
+		int makespan() const { return _upper_bound; }
+		int lower_bound() const { return _lower_bound; }
+		bool optimal() const { return _optimal; }
+		size_t nb_nodes() const { return _nb_nodes; }
+		double root_bound() const { return _root_bound; }
+		int justification_saving() const { return _justification_saving; }
+		const std::vector<int>& finish_times() const { return _best_activity_finish_times; }
 	};
 
 	///////////////////////////////////////////////////////////////////////////
@@ -73,17 +180,88 @@ namespace RCPSP // resource-constrained project scheduling problem
 	class IP : public Algorithm
 	{
 		std::unique_ptr<operations_research::MPSolver> _solver; // OR Tools solver
-		std::string _solver_type = "SCIP";
+
+		LinearModel _model; // the model as built, loaded into _solver and optionally exported
+		std::vector<operations_research::MPVariable*> _variables; // [v] == solver variable of model variable v
+
+		// start variables only within the window [_first_start[j], _first_start[j] + nb variables of j)
+		// the variables of activity j are the model variables _x_offsets[j] .. _x_offsets[j+1]-1
+		std::vector<int> _x_offsets;
+		std::vector<int> _first_start;
+		int _horizon = 0;
+		std::vector<int> _heuristic_start_times; // warm start, its makespan is the horizon
+
+		std::chrono::steady_clock::time_point _start_time; // of the run, the time limit covers all solves
+
+		double remaining_time() const { return _max_computation_time - std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count(); }
+		bool _disaggregated = false; // precedence constraints per period instead of one per precedence relation
+
+		int x(int j, int t) const { return _x_offsets[j] + t - _first_start[j]; }
+		int first_start(int j) const { return _first_start[j]; }
+		int last_start(int j) const { return _first_start[j] + _x_offsets[j + 1] - _x_offsets[j] - 1; }
 
 		void build_problem();
+		void solve_relaxation();
+		void prepare_solver(operations_research::MPSolverParameters& parameters);
 		void solve_problem();
+		void search_horizon(); // iterative horizon tightening instead of one solve
+		int read_schedule(std::vector<int>& start_times) const; // from the solution of _solver, returns its makespan
+		void report_schedule(const std::vector<int>& start_times);
+		void use_heuristic_schedule();
 
 		bool _output_screen = false;
-		double _max_computation_time = 1800; // seconds
 
 	public:
+		IP() { _max_computation_time = 1800; }
+
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Continuous-time MIP with on/off event variables (Kone et al., 2011): z_ae = 1 if activity a is in progress just after
+	// event e, with one event per activity of positive duration; the size of the model depends on the number of activities
+	// only, not on the durations or the horizon
+	class EventIP : public Algorithm
+	{
+		std::unique_ptr<operations_research::MPSolver> _solver; // OR Tools solver
+
+		LinearModel _model;
+		std::vector<operations_research::MPVariable*> _variables; // [v] == solver variable of model variable v
+
+		std::vector<int> _event_activities; // [a] == the a-th activity of positive duration; the activities without duration are left out
+		int _horizon = 0;
+		std::vector<int> _heuristic_start_times; // warm start, its makespan is the horizon
+
+		int nb_events() const { return static_cast<int>(_event_activities.size()); }
+		int z(int a, int e) const { return a * nb_events() + e; }
+		int t(int e) const { return nb_events() * nb_events() + e; } // date of event e
+		int makespan_variable() const { return nb_events() * (nb_events() + 1); }
+
+		void build_problem();
+		void solve_problem();
+		void complete_schedule(std::vector<int>& start_times) const; // start times of the activities without duration
+		void report_schedule(const std::vector<int>& start_times);
+
+		bool _output_screen = false;
+
+	public:
+		EventIP() { _max_computation_time = 1800; }
+
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// CP-SAT model with an interval variable per activity and a cumulative constraint per resource type
+	class CPSAT : public Algorithm
+	{
+		bool _output_screen = false;
+
+	public:
+		CPSAT() { _max_computation_time = 1800; }
+
 		void run(bool verbose) override;
-		void set_max_time(double time) { _max_computation_time = time; }
 	};
 
 	///////////////////////////////////////////////////////////////////////////
@@ -107,6 +285,14 @@ namespace RCPSP // resource-constrained project scheduling problem
 			int level_tree = -1;
 			int lower_bound = 0;
 			int decision_point = 0;
+			std::vector<int> ancestors; // ids of the nodes on the path from the root
+			uint64_t order = 0; // breaks the ties of the lower bound: the order of creation, random after a restart
+			int rollout_makespan = 0; // makespan of the completion of the partial schedule by the serial SGS, if computed
+
+			// score of the delaying alternative, less is better: the longest remaining critical path of the delayed
+			// activities and their work, relative to the availabilities
+			int delayed_rcpl = 0;
+			double delayed_energy = 0;
 
 			std::vector<bool> act_in_PS; // [i] == true if activity i is in partial schedule
 			std::vector<bool> act_active; // [i] == true if activity i is active
@@ -124,12 +310,11 @@ namespace RCPSP // resource-constrained project scheduling problem
 		void print_node(const Node& node);
 		void print_cutset(const Cutset& cutset);
 
-		int calculate_RCPL(int activity);
-		bool transitive_precedence_between_activities_forward(int start, int target, int act_recursion);
-		bool transitive_precedence_between_activities_backward(int start, int target, int act_recursion);
 		std::vector<std::vector<int>> find_min_delaying_sets(const Node& node, const std::vector<int>& res_to_release);
 
 		void clear_all();
+		void create_root_node();
+		bool explore_first(const Node& a, const Node& b) const; // order of the nodes on the deepest level
 		void procedure();
 
 		size_t _nodes_evaluated = 0;
@@ -139,8 +324,190 @@ namespace RCPSP // resource-constrained project scheduling problem
 		size_t _nb_times_theorem3_applied = 0;
 		size_t _nb_times_theorem4_applied = 0;
 
+		std::chrono::steady_clock::time_point _start_time;
+		bool _time_limit_reached = false; // or stopped by the portfolio: the search is not complete
+
+		// Filtered beam search (beam width > 0): the tree is explored level by level, and when a level is reached only its
+		// best _beam_width nodes, on the makespan of a rollout and then the lower bound, are kept; the rollouts are complete
+		// schedules and also improve the upper bound
+		int _beam_width = 0;
+		int _beam_level = -1; // level filtered last
+		size_t _nodes_beam_filtered = 0;
+		SGS _rollout_sgs;
+		std::vector<int> _rollout_priority; // latest start activity list
+		std::vector<int> _rollout_list;
+		std::vector<int> _rollout_finish_times;
+
+		bool _rollout_ordering = false; // rollouts of the children of the exact search
+		int rollout(const Node& node); // complete the partial schedule with the serial SGS, returns the makespan
+		void filter_level(int level);
+
+		// Restarts: after a run of _restart_limit nodes the search starts again from the root, with the children of
+		// equal lower bound in a random order; the best schedule and the cutsets of the subtrees that were searched
+		// completely are kept, so the search remains exact
+		std::string _restart_policy;
+		size_t _restart_limit = 0; // nodes of the current run, 0 for no restarts
+		size_t _nodes_at_restart = 0;
+		int _nb_restarts = 0;
+		std::mt19937_64 _restart_rng;
+
+		static size_t luby(size_t i); // 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+		size_t restart_limit(int run) const;
+		void restart();
+
+
+	public:
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Genetic algorithm of Hartmann (1998) on activity lists decoded with the serial SGS: two-point crossover, swap
+	// mutation and ranking selection. The children of a generation are created and decoded in parallel, every thread
+	// with its own random number generator, so that a run is reproducible for a fixed seed and number of threads.
+	class GA : public Algorithm
+	{
+		struct Individual
+		{
+			std::vector<int> activity_list;
+			int makespan = 0;
+		};
+
+		// state of one thread
+		struct Worker
+		{
+			SGS sgs;
+			Justification justification;
+			std::mt19937_64 rng;
+			std::vector<int> finish_times;
+			std::vector<char> listed;
+		};
+
+		int _population_size = 60;
+		double _mutation_probability = 0.05;
+		size_t _max_schedules = 50000;
+
+		std::vector<Individual> _individuals; // [0, population size) the population sorted on makespan, then the children
+		std::vector<int> _parents; // the children at 2p and 2p+1 after the population descend from _parents[2p] and _parents[2p+1]
+		std::vector<Worker> _workers;
+
+		size_t _nb_schedules = 0;
+		int _nb_generations = 0;
+		std::chrono::steady_clock::time_point _start_time;
+
+		void crossover(const Individual& mother, const Individual& father, Individual& child, int first, int last, Worker& worker) const;
+		void mutate(Individual& individual, Worker& worker) const;
+		int evaluate(Individual& individual, Worker& worker) const; // decode, and justify if enabled; returns the makespan
+		void create_children(Worker& worker, int first_pair, int last_pair);
+		void search(int nb_threads);
 
 	public:
+		GA() { _max_computation_time = 60; }
+
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Simulated annealing on activity lists with precedence feasible shift and swap moves and geometric cooling;
+	// a move is evaluated by decoding the list again from the first changed position only
+	class SA : public Algorithm
+	{
+		size_t _max_schedules = 200000; // moves
+
+		std::vector<int> _best_activity_list;
+		int _best_makespan = 0;
+
+		size_t _nb_schedules = 0;
+		size_t _nb_accepted = 0;
+		size_t _nb_positions_decoded = 0;
+		std::chrono::steady_clock::time_point _start_time;
+
+		// move the activity at position from to a random position in the list; return the new position, from if none
+		int shift(std::vector<int>& activity_list, int from, std::mt19937_64& rng) const;
+		int swap(std::vector<int>& activity_list, int from, std::mt19937_64& rng) const;
+		void search();
+
+	public:
+		SA() { _max_computation_time = 60; }
+
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Large neighbourhood search: a block of consecutive activities of the best schedule, in order of start time, is freed
+	// and re-optimized by a time-limited DH or CP-SAT run on a subproject in which the activities that started earlier are
+	// resource reservations and release dates. Several threads repair neighbourhoods of one shared incumbent.
+	class LNS : public Algorithm
+	{
+		// shared by the threads, under _mutex
+		std::mutex _mutex;
+		std::vector<int> _best_activity_list;
+		int _best_makespan = 0;
+		size_t _nb_repairs = 0;
+		size_t _nb_optimal_repairs = 0;
+		size_t _nb_improvements = 0;
+		bool _stop = false;
+
+		double _repair_time = 0.1; // seconds per repair: many short repairs work better than a few long ones
+		size_t _max_repairs = 0; // 0 for no limit
+		std::chrono::steady_clock::time_point _start_time;
+
+		void build_subproject(const std::vector<int>& order, const std::vector<int>& finish_times, int first, int last,
+			Instance& subproject, std::vector<int>& index) const;
+		void repair(int thread);
+
+	public:
+		LNS() { _max_computation_time = 60; }
+
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Multi-pass sampling: regret-based biased random sampling on the latest start times, with the parallel and the serial
+	// SGS in turn. Every thread runs its own share of the passes with its own random number generator, and the threads
+	// share the best schedule, so that a run that is not stopped by the time limit is reproducible for a fixed seed and
+	// number of threads.
+	class Sampling : public Algorithm
+	{
+		// shared by the threads, under _mutex
+		std::mutex _mutex;
+		std::tuple<int, int, size_t> _best{ std::numeric_limits<int>::max(), 0, 0 }; // makespan, thread and pass of the best schedule
+		bool _best_parallel = false; // found by the parallel SGS
+		std::atomic<int> _best_makespan{ std::numeric_limits<int>::max() }; // read by the threads without the lock
+		std::atomic<size_t> _nb_passes{ 0 };
+
+		size_t _max_passes = 10000;
+		std::chrono::steady_clock::time_point _start_time;
+
+		void sample(int thread, size_t nb_passes);
+
+	public:
+		Sampling() { _max_computation_time = 60; }
+
+		void run(bool verbose) override;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Portfolio: DH, CP-SAT and simulated annealing race on their own threads with shared bounds, so that each of them
+	// prunes with the best schedule of any of them, and the first proof of optimality stops the others
+	class Portfolio : public Algorithm
+	{
+		struct Engine
+		{
+			std::string name;
+			std::unique_ptr<Algorithm> algorithm;
+			double elapsed_time = 0;
+		};
+
+		std::vector<Engine> _engines;
+
+	public:
+		Portfolio() { _max_computation_time = 1800; }
+
 		void run(bool verbose) override;
 	};
 
@@ -3,6 +3,9 @@
 #include <stdexcept>
 #include <list>
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_set>
 
 
 
@@ -53,6 +56,13 @@ namespace RCPSP
 		_RCPL.clear();
 		_upper_bound = std::numeric_limits<int>::max();
 		_best_activity_finish_times.clear();
+		_lower_bound = 0;
+		_optimal = false;
+		_time_limit_reached = false;
+		_beam_level = -1;
+		_nodes_beam_filtered = 0;
+		_nb_restarts = 0;
+		_nodes_at_restart = 0;
 
 		// statistics
 		_nodes_evaluated = 0;
@@ -64,69 +74,10 @@ namespace RCPSP
 	}
 
 
-	int DH::calculate_RCPL(int activity)
-	{
-		if (activity == _activities.size() - 1)
-			return 0;	// dummy end activity
-
-		int cp = 0;
-		auto& act = _activities[activity];
-
-		for (auto&& suc : act.successors)
-		{
-			int val = act.duration + calculate_RCPL(suc);
-			if (val > cp)
-				cp = val;
-		}
-		return cp;
-	}
-
-
-	bool DH::transitive_precedence_between_activities_forward(int start, int target, int act_recursion)
-	{
-		bool exists = false;
-
-		// end
-		if (act_recursion == target)
-			return true;	// target reached => path exists
-		else if (act_recursion == 0 || act_recursion == _activities.size() - 1)
-			return false;	// dummy start or end reached => no path exists
-
-		// look forward
-		for (auto&& suc : _activities[act_recursion].successors)
-		{
-			if (transitive_precedence_between_activities_forward(start, target, suc))
-				exists = true;
-		}
-
-		return exists;
-	}
-
-
-	bool DH::transitive_precedence_between_activities_backward(int start, int target, int act_recursion)
-	{
-		bool exists = false;
-
-		// end
-		if (act_recursion == target)
-			return true;	// target reached => path exists
-		else if (act_recursion == 0 || act_recursion == _activities.size() - 1)
-			return false;	// dummy start or end reached => no path exists
-
-		// look backward
-		for (auto&& pred : _activities[act_recursion].predecessors)
-		{
-			if (transitive_precedence_between_activities_backward(start, target, pred))
-				exists = true;
-		}
-
-		return exists;
-	}
-
-
 	std::vector<std::vector<int>> DH::find_min_delaying_sets(const Node& node, const std::vector<int>& res_to_release)
 	{
 		std::vector<std::vector<int>> result;
+		const int nb_resources = _resource_availabilities.size();
 
 		// activities for which to calculate delaying sets
 		std::vector<int> acts;
@@ -136,68 +87,62 @@ namespace RCPSP
 			}
 		}
 
+		// available[p][k] == what the activities acts[p..] can release together of resource type k
+		std::vector<std::vector<int>> available(acts.size() + 1, std::vector<int>(nb_resources, 0));
+		for (int p = static_cast<int>(acts.size()) - 1; p >= 0; --p)
+			for (int k = 0; k < nb_resources; ++k)
+				available[p][k] = available[p + 1][k] + _activities[acts[p]].resource_requirements[k];
 
-		// Iterate over all possible subsets using bitmasks
-		for (int mask = 0; mask < (1 << acts.size()); mask++)
-		{
-			std::vector<int> currentset;  // Current subset (indices)
-			std::vector<int> currentsum;  // Sum of weights in current subset
-			for (int k = 0; k < _resource_availabilities.size(); ++k)
-				currentsum.push_back(0);
 
-			// Build the subset and compute its sum
-			for (int i = 0; i < acts.size(); i++)
-			{
-				if (mask & (1 << i))
-				{  // If bit i is set, include item i
-					currentset.push_back(acts[i]);
-					for (int k = 0; k < _resource_availabilities.size(); ++k)
-						currentsum[k] += _activities[acts[i]].resource_requirements[k];
-				}
-			}
-
-			// Check if sum is at least W
+		// Include or exclude one activity at a time. A subset that releases enough is not extended, as its supersets
+		// are not minimal, and neither is a subset that cannot release enough with the activities that are left.
+		std::vector<int> currentset;  // Current subset (indices)
+		std::vector<int> currentsum(nb_resources, 0);  // Sum of weights in current subset
+		std::function<void(int)> enumerate = [&](int position)
+		{
 			bool sufficient_resources = true;
-			for (int k = 0; k < _resource_availabilities.size(); ++k) {
-				if (currentsum[k] < res_to_release[k]) {
+			for (int k = 0; k < nb_resources; ++k) {
+				if (currentsum[k] + available[position][k] < res_to_release[k])
+					return;
+				if (currentsum[k] < res_to_release[k])
 					sufficient_resources = false;
-					break;
-				}
 			}
 
 			if (sufficient_resources)
 			{
-				bool minimal = true;
-
 				// Check minimality: removing any item should make sum < W
-				for (int idx : currentset) // idx is element from set acts 
+				for (int idx : currentset) // idx is element from set acts
 				{
 					bool enough_after_del_act = true;
-					for (int k = 0; k < _resource_availabilities.size(); ++k)
+					for (int k = 0; k < nb_resources; ++k)
 					{
 						if (currentsum[k] - _activities[idx].resource_requirements[k] < res_to_release[k])
 						{
 							enough_after_del_act = false;
+							break;
 						}
 					}
 					if (enough_after_del_act)
-					{
-						minimal = false;
-						break;
-					}
+						return;
 				}
 
-				// If subset is minimal, output its indices
-				if (minimal)
-				{
-					result.push_back(currentset);
-					/*for (int i = 0; i < currentset.size(); i++)
-					{
-						result.push_back(currentset);
-					}*/
-				}
+				result.push_back(currentset);
+				return;
 			}
-		}
+
+			// with acts[position]
+			currentset.push_back(acts[position]);
+			for (int k = 0; k < nb_resources; ++k)
+				currentsum[k] += _activities[acts[position]].resource_requirements[k];
+			enumerate(position + 1);
+			currentset.pop_back();
+			for (int k = 0; k < nb_resources; ++k)
+				currentsum[k] -= _activities[acts[position]].resource_requirements[k];
+
+			// without it
+			enumerate(position + 1);
+		};
+		enumerate(0);
 
 
 		return result;
@@ -207,27 +152,68 @@ namespace RCPSP
 
 
 
-	/**************************************************************************
-	*                            Main algorithm
-	**************************************************************************/
+	int DH::rollout(const Node& node)
+	{
+		// the activities of the partial schedule in order of start time, then the others in latest start order
+		_rollout_list.clear();
+		for (int i : _rollout_priority)
+			if (node.act_in_PS[i])
+				_rollout_list.push_back(i);
+		std::stable_sort(_rollout_list.begin(), _rollout_list.end(), [&](int a, int b) {
+			return node.act_finish_time[a] - _activities[a].duration < node.act_finish_time[b] - _activities[b].duration; });
+		for (int i : _rollout_priority)
+			if (!node.act_in_PS[i])
+				_rollout_list.push_back(i);
+
+		const int makespan = _rollout_sgs.decode(_rollout_list.data(), _rollout_finish_times.data());
+		if (makespan < _upper_bound)
+		{
+			_upper_bound = makespan;
+			_best_activity_finish_times = _rollout_finish_times;
+			share_upper_bound(_upper_bound);
+			_output << "\nNew best solution found by a rollout! T = " << _upper_bound;
+		}
+		return makespan;
+	}
 
-	void DH::procedure()
+
+	void DH::filter_level(int level)
 	{
-		// INITIALIZE	 
-		// Compute remaining critical path length for each activity
+		std::vector<int> nodes; // indices in _remaining_nodes of the nodes on this level
+		for (int i = 0; i < _remaining_nodes.size(); ++i)
 		{
-			_output << "\n\nCompute RCPL for every activity\n";
-			_RCPL.reserve(_activities.size());
-			for (int i = 0; i < _activities.size(); ++i)
+			if (_remaining_nodes[i].level_tree == level)
 			{
-				int RCPL = calculate_RCPL(i);
-				_RCPL.push_back(RCPL);
-
-				_output << "RCPL[" << i + 1 << "] = " << RCPL << "\t";
+				_remaining_nodes[i].rollout_makespan = rollout(_remaining_nodes[i]);
+				nodes.push_back(i);
+			}
+		}
+		if (nodes.size() <= static_cast<size_t>(_beam_width))
+			return;
+
+		std::stable_sort(nodes.begin(), nodes.end(), [this](int a, int b) {
+			return std::make_pair(_remaining_nodes[a].rollout_makespan, _remaining_nodes[a].lower_bound)
+				< std::make_pair(_remaining_nodes[b].rollout_makespan, _remaining_nodes[b].lower_bound); });
+		std::vector<bool> discard(_remaining_nodes.size(), false);
+		for (size_t n = _beam_width; n < nodes.size(); ++n)
+			discard[nodes[n]] = true;
+		for (int i = _remaining_nodes.size() - 1; i >= 0; --i)
+		{
+			if (discard[i])
+			{
+				_remaining_nodes.erase(_remaining_nodes.begin() + i);
+				++_nodes_beam_filtered;
 			}
 		}
+		_output << "\n\nBeam search: keep the best " << _beam_width << " of " << nodes.size() << " nodes on level " << level;
+	}
 
-		// Create root node
+
+
+
+
+	void DH::create_root_node()
+	{
 		_remaining_nodes.push_back(Node());
 		{
 			_output << "\n\nCreate root node";
@@ -266,6 +252,119 @@ namespace RCPSP
 				root_node.cutset.act_unassigned[s] = true; // successors of dummy start			
 		}
 		if (_verbose) print_node(_remaining_nodes.back());
+	}
+
+
+	bool DH::explore_first(const Node& a, const Node& b) const
+	{
+		// the lower bound first, then the score of the delaying alternative; after a restart, the random order replaces
+		// the score, which would lead the search into the subtrees of the first run again
+		if (a.lower_bound != b.lower_bound)
+			return a.lower_bound < b.lower_bound;
+		if (_nb_restarts == 0)
+		{
+			const auto score_a = std::make_tuple(a.rollout_makespan, a.delayed_rcpl, a.delayed_energy);
+			const auto score_b = std::make_tuple(b.rollout_makespan, b.delayed_rcpl, b.delayed_energy);
+			if (score_a != score_b)
+				return score_a < score_b;
+		}
+		return a.order < b.order;
+	}
+
+
+	size_t DH::luby(size_t i)
+	{
+		// i == 2^k - 1 ends a block of the sequence, which then restarts
+		size_t block = 1;
+		while (block < i + 1)
+			block = 2 * block;
+		if (block == i + 1)
+			return block / 2;
+		return luby(i - block / 2 + 1);
+	}
+
+
+	size_t DH::restart_limit(int run) const
+	{
+		// limits that do not fit in a size_t are capped, which means that the run does not end
+		const size_t max_limit = std::numeric_limits<size_t>::max();
+		if (_restart_policy == "luby")
+		{
+			const size_t factor = luby(run + 1);
+			if (_solver_options.restart_nodes > max_limit / factor)
+				return max_limit;
+			return _solver_options.restart_nodes * factor;
+		}
+		else if (_restart_policy == "geometric")
+		{
+			const double limit = _solver_options.restart_nodes * std::pow(1.5, std::min(run, 100));
+			if (limit >= static_cast<double>(max_limit))
+				return max_limit;
+			return static_cast<size_t>(limit);
+		}
+		return 0;
+	}
+
+
+	void DH::restart()
+	{
+		// the nodes with unexplored descendants are the ancestors of the remaining nodes; their cutsets do not dominate,
+		// since their subtrees have not been searched completely
+		std::unordered_set<int> open_nodes;
+		for (auto&& node : _remaining_nodes)
+			open_nodes.insert(node.ancestors.begin(), node.ancestors.end());
+		const size_t nb_cutsets = _saved_cutsets.size();
+		_saved_cutsets.erase(std::remove_if(_saved_cutsets.begin(), _saved_cutsets.end(),
+			[&open_nodes](const Cutset& cutset) { return open_nodes.count(cutset.node) > 0; }), _saved_cutsets.end());
+
+		_remaining_nodes.clear();
+		++_nb_restarts;
+		_nodes_at_restart = _nodes_evaluated;
+		_restart_limit = restart_limit(_nb_restarts);
+		_output << "\n\nRestart " << _nb_restarts << " after " << _nodes_evaluated << " nodes: " << _saved_cutsets.size() << " of "
+			<< nb_cutsets << " cutsets kept, next run of " << _restart_limit << " nodes";
+
+		create_root_node();
+	}
+
+
+	/**************************************************************************
+	*                            Main algorithm
+	**************************************************************************/
+
+	void DH::procedure()
+	{
+		// INITIALIZE	 
+		// Compute remaining critical path length for each activity
+		{
+			_output << "\n\nCompute RCPL for every activity\n";
+			_RCPL.reserve(_activities.size());
+			for (int i = 0; i < _activities.size(); ++i)
+			{
+				int RCPL = _instance.rcpl[i];
+				_RCPL.push_back(RCPL);
+
+				_output << "RCPL[" << i + 1 << "] = " << RCPL << "\t";
+			}
+		}
+
+		// Rollouts (beam search or ordering of the children): the latest start schedule is the first upper bound, so that
+		// there is always a solution
+		if (_beam_width > 0 || _rollout_ordering)
+		{
+			_rollout_sgs.reset(_instance);
+			latest_start_activity_list(_rollout_priority);
+			_rollout_finish_times.resize(_activities.size());
+			_upper_bound = _rollout_sgs.decode(_rollout_priority, _best_activity_finish_times);
+			share_upper_bound(_upper_bound);
+			if (_beam_width > 0)
+				_output << "\n\nBeam search with beam width " << _beam_width << ", initial upper bound " << _upper_bound;
+			else
+				_output << "\n\nRollouts of the delaying alternatives, initial upper bound " << _upper_bound;
+		}
+
+		// Create root node
+		create_root_node();
 
 
 
@@ -273,10 +372,11 @@ namespace RCPSP
 		// Branching until no nodes left
 		while (true)
 		{
-			// remove all nodes with LB >= UB
+			// remove all nodes with LB >= UB, the best schedule of the portfolio included
+			const int upper_bound = std::min(_upper_bound, shared_upper_bound());
 			for (int i = _remaining_nodes.size() - 1; i >= 0; --i)
 			{
-				if (_remaining_nodes[i].lower_bound >= _upper_bound)
+				if (_remaining_nodes[i].lower_bound >= upper_bound)
 				{
 					_output << "\n\nNext node on this level is LB dominated:";
 					if (_verbose) print_node(_remaining_nodes[i]);
@@ -293,9 +393,49 @@ namespace RCPSP
 				break; // done
 			}
 
+			// stop when the time limit is reached, or when another algorithm of the portfolio has proven the optimum
+			std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - _start_time;
+			if (elapsed_time.count() > _max_computation_time || shared_stop())
+			{
+				_output << "\n\nTime limit reached: STOP";
+				_time_limit_reached = true;
+				break;
+			}
+
+			// restart from the root when the run has used up its nodes
+			if (_restart_limit > 0 && _nodes_evaluated - _nodes_at_restart >= _restart_limit)
+				restart();
+
 
 			// find node on current level of tree with best bound
 			Node current_node;
+			if (_beam_width > 0)
+			{
+				// beam search: the shallowest level, filtered when it is reached, and on it the node with the best rollout
+				int level_tree = std::numeric_limits<int>::max();
+				for (auto&& node : _remaining_nodes) {
+					if (node.level_tree < level_tree) {
+						level_tree = node.level_tree;
+					}
+				}
+				if (level_tree != _beam_level)
+				{
+					filter_level(level_tree);
+					_beam_level = level_tree;
+				}
+
+				int index_node = -1;
+				for (auto i = 0; i < _remaining_nodes.size(); ++i) {
+					if (_remaining_nodes[i].level_tree == level_tree && (index_node < 0
+						|| std::make_pair(_remaining_nodes[i].rollout_makespan, _remaining_nodes[i].lower_bound)
+						< std::make_pair(_remaining_nodes[index_node].rollout_makespan, _remaining_nodes[index_node].lower_bound))) {
+						index_node = i;
+					}
+				}
+				current_node = _remaining_nodes[index_node];
+				_remaining_nodes.erase(_remaining_nodes.begin() + index_node);
+			}
+			else
 			{
 				// find deepest level
 				int level_tree = -1;
@@ -305,12 +445,10 @@ namespace RCPSP
 					}
 				}
 
-				// find best LB on this level
+				// find best node on this level: best LB, then best score
 				int index_node = -1;
-				int best_LB = std::numeric_limits<int>::max();
 				for (auto i = 0; i < _remaining_nodes.size(); ++i) {
-					if (_remaining_nodes[i].level_tree == level_tree && _remaining_nodes[i].lower_bound < best_LB) {
-						best_LB = _remaining_nodes[i].lower_bound;
+					if (_remaining_nodes[i].level_tree == level_tree && (index_node < 0 || explore_first(_remaining_nodes[i], _remaining_nodes[index_node]))) {
 						index_node = i;
 					}
 				}
@@ -360,6 +498,7 @@ namespace RCPSP
 						{
 							_upper_bound = current_node.act_finish_time[dummy_finish_index];
 							_best_activity_finish_times = current_node.act_finish_time;
+							share_upper_bound(_upper_bound);
 
 							_output << "\nNew best solution found! T = " << _upper_bound;
 						}
@@ -375,7 +514,7 @@ namespace RCPSP
 				for (auto&& sc : _saved_cutsets)
 				{
 					if (sc.node != current_node.cutset.node
-						&& sc.node != current_node.cutset.parent_node // different path in the tree!
+						&& std::find(current_node.ancestors.begin(), current_node.ancestors.end(), sc.node) == current_node.ancestors.end() // different path in the tree!
 						&& sc.act_unassigned == current_node.cutset.act_unassigned
 						&& sc.decision_point <= current_node.cutset.decision_point)
 					{
@@ -476,8 +615,7 @@ namespace RCPSP
 								{
 									if (j != i && !current_node.act_in_PS[j]) // unassigned, so not yet in PS
 									{
-										if (!transitive_precedence_between_activities_forward(i, j, i)
-											&& !transitive_precedence_between_activities_backward(i, j, i)) // can they be scheduled in parallel?
+										if (!_instance.precedes(i, j) && !_instance.precedes(j, i)) // can they be scheduled in parallel?
 										{
 											bool feasible = true;
 											for (int k = 0; k < _resource_availabilities.size(); ++k)
@@ -692,7 +830,9 @@ namespace RCPSP
 								// copy current node
 								_remaining_nodes.push_back(Node(current_node));
 								_remaining_nodes.back().id = _nodes_evaluated;
+								_remaining_nodes.back().order = (_nb_restarts > 0) ? _restart_rng() : _nodes_evaluated;
 								_remaining_nodes.back().level_tree++; // increase level of tree
+								_remaining_nodes.back().ancestors.push_back(current_node.id);
 
 								// delay the delayed activity
 								for (auto&& actdel : subset)
@@ -809,6 +949,20 @@ namespace RCPSP
 									}
 									_output << "\nThe new lower bound is LB = " << _remaining_nodes.back().lower_bound;
 
+									// score of the delaying alternative
+									int delayed_rcpl = 0;
+									double delayed_energy = 0;
+									for (auto&& actdel : subset)
+									{
+										delayed_rcpl = std::max(delayed_rcpl, _RCPL[actdel]);
+										for (int k = 0; k < _resource_availabilities.size(); ++k)
+											delayed_energy += static_cast<double>(_activities[actdel].duration)
+												* _activities[actdel].resource_requirements[k] / _resource_availabilities[k];
+									}
+									_remaining_nodes.back().delayed_rcpl = delayed_rcpl;
+									_remaining_nodes.back().delayed_energy = delayed_energy;
+									_remaining_nodes.back().rollout_makespan = (_rollout_ordering && _beam_width == 0) ? rollout(_remaining_nodes.back()) : 0;
+
 									// update cutset
 									{
 										_remaining_nodes.back().cutset.node = _remaining_nodes.back().id;
@@ -839,29 +993,71 @@ namespace RCPSP
 
 	void DH::run(bool verbose)
 	{
-		_verbose = verbose;
-		_output.set_on(true);
+		_verbose = verbose && !_silent;
+		_output.set_on(!_silent);
 		_output << "\nStarting branch-and-bound procedure of Demeulemeester and Herroelen ...\n";
-		_output.set_on(verbose);
+		_output.set_on(_verbose);
 
-		auto start_time = std::chrono::system_clock::now();
+		_start_time = std::chrono::steady_clock::now();
 
 		// Reset all values
 		clear_all();
+		_beam_width = std::max(_solver_options.beam_width, 0);
+		_rollout_ordering = _solver_options.rollouts;
+
+		_restart_policy = _solver_options.restarts;
+		std::transform(_restart_policy.begin(), _restart_policy.end(), _restart_policy.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (_restart_policy != "none" && _restart_policy != "luby" && _restart_policy != "geometric")
+		{
+			throw std::invalid_argument("Unknown restart policy " + _solver_options.restarts + " (use none, luby or geometric)");
+		}
+		_restart_limit = (_beam_width > 0) ? 0 : restart_limit(0); // the beam search does not restart
+		std::seed_seq seed{ _solver_options.seed };
+		_restart_rng.seed(seed);
 
 		// Main procedure
 		procedure();
 
+		// Bounds: without a time limit the search is complete, otherwise the remaining nodes bound the optimum; in a
+		// portfolio, the nodes pruned with the schedules of the other algorithms are bounded by the best of those
+		_lower_bound = std::min(_upper_bound, shared_upper_bound());
+		for (auto&& node : _remaining_nodes)
+			_lower_bound = std::min(_lower_bound, node.lower_bound);
+		if (_beam_width > 0)
+		{
+			// the beam may have discarded part of the tree: only the bound of the project itself holds
+			_lower_bound = std::min(_upper_bound, simple_lower_bound());
+		}
+		_optimal = !_best_activity_finish_times.empty() && _upper_bound == _lower_bound;
+		share_lower_bound(_lower_bound);
+		_nb_nodes = _nodes_evaluated;
+
 		// Print statistics
-		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::system_clock::now() - start_time;
-		_output.set_on(true);
-		_output << "\n\n\nOptimal solution found with makespan " << _upper_bound;
-		_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::steady_clock::now() - _start_time;
+		_output.set_on(!_silent);
+		if (_best_activity_finish_times.empty())
+		{
+			_output << "\n\n\nNo solution found within the time limit";
+		}
+		else
+		{
+			if (_optimal)
+				_output << "\n\n\nOptimal solution found with makespan " << _upper_bound;
+			else if (_time_limit_reached)
+				_output << "\n\n\nTime limit reached. Best solution found has makespan " << _upper_bound << " (lower bound " << _lower_bound << ")";
+			else
+				_output << "\n\n\nBest solution found has makespan " << _upper_bound << " (lower bound " << _lower_bound << ")";
+			_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		}
 		_output << "\n\nElapsed time (s): " << elapsed_time.count();
 		_output << "\nNodes evaluated: " << _nodes_evaluated;
 		_output << "\nNodes LB dominated: " << _nodes_LB_dominated;
 		_output << "\nNodes cutset dominated: " << _nodes_cutset_dominated;
 		_output << "\nNodes left-shift dominated: " << _nodes_leftshift_dominated;
+		if (_beam_width > 0)
+			_output << "\nNodes beam filtered: " << _nodes_beam_filtered;
+		if (_restart_policy != "none")
+			_output << "\nRestarts: " << _nb_restarts;
 		_output << "\nTheorem 3 applied: " << _nb_times_theorem3_applied;
 		_output << "\nTheorem 4 applied: " << _nb_times_theorem4_applied;
 	}
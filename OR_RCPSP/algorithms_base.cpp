@@ -1,5 +1,6 @@
 #include "algorithms.h"
-#include <fstream>
+#include <algorithm>
+#include <functional>
 #include <random>
 #include <stdexcept>
 #include <iostream>
@@ -93,72 +94,66 @@ namespace RCPSP
 	///////////////////////////////////////////////////////////////////////////
 
 
-	void Algorithm::read_data(const std::string& filename)
+	void SharedBounds::improve_upper_bound(int makespan)
 	{
-		// DATA SHOULD INCLUDE DUMMY START AND END ACTIVITIES
+		int current = upper_bound.load();
+		while (makespan < current && !upper_bound.compare_exchange_weak(current, makespan)) {}
+		if (lower_bound.load() >= upper_bound.load())
+			stop = true;
+	}
 
-		// clear old data
-		_resource_availabilities.clear();
-		_activities.clear();
 
+	void SharedBounds::improve_lower_bound(int bound)
+	{
+		int current = lower_bound.load();
+		while (bound > current && !lower_bound.compare_exchange_weak(current, bound)) {}
+		if (lower_bound.load() >= upper_bound.load())
+			stop = true;
+	}
 
-		std::ifstream file;
-		file.open(filename);
-		if (!file.is_open())
-		{
-			throw std::invalid_argument("Couldn't open the file with name " + filename);
-		}
 
-		int nb_activities = 0, nb_resources = 0;
-		file >> nb_activities >> nb_resources;
+	///////////////////////////////////////////////////////////////////////////
 
-		_resource_availabilities.reserve(nb_resources);
-		for (int k = 0; k < nb_resources; ++k)
-		{
-			int val;
-			file >> val;
-			_resource_availabilities.push_back(val);
-		}
 
-		_activities.reserve(nb_activities);
-		for (int i = 0; i < nb_activities; ++i)
-		{
-			_activities.push_back(Activity());
-			_activities.back().id = i;
+	void Algorithm::read_data(const std::string& filename, bool use_cache)
+	{
+		// DATA SHOULD INCLUDE DUMMY START AND END ACTIVITIES
+		Instance instance;
+		if (use_cache)
+			read_instance_cached(filename, instance);
+		else
+			read_instance(filename, instance);
+		load_instance(instance);
+	}
 
-			int dur;
-			file >> dur;
-			_activities.back().duration = dur;
 
-			_activities.back().resource_requirements.reserve(nb_resources);
-			for (int k = 0; k < nb_resources; ++k)
-			{
-				int res;
-				file >> res;
-				_activities.back().resource_requirements.push_back(res);
-			}
+	void Algorithm::load_instance(const Instance& instance)
+	{
+		// clear old data
+		_resource_availabilities.clear();
+		_activities.clear();
+		_instance = instance;
 
-			int nbsucc;
-			file >> nbsucc;
-			_activities.back().successors.reserve(nbsucc);
-			for (int s = 0; s < nbsucc; ++s)
-			{
-				int suc;
-				file >> suc;
-				--suc; // numbering starts at 1 instead of 0
-				_activities.back().successors.push_back(suc);
-			}
-		}
+		instance.validate();
+		if (_instance.predecessor_offsets.empty())
+			_instance.build_predecessors();
+		if (!_instance.preprocessed())
+			_instance.preprocess();
 
+		const int nb_activities = instance.nb_activities;
+		const int nb_resources = instance.nb_resources;
+		_resource_availabilities = instance.resource_availabilities;
 
-		// calculate predecessors
-		for (int i = 0; i < _activities.size(); ++i)
+		_activities.resize(nb_activities);
+		for (int i = 0; i < nb_activities; ++i)
 		{
-			int pred = i;
-			for (auto&& suc : _activities[i].successors)
-			{
-				_activities[suc].predecessors.push_back(pred);
-			}
+			Activity& act = _activities[i];
+			act.id = i;
+			act.duration = instance.durations[i];
+			act.resource_requirements.assign(instance.requirements.begin() + i * nb_resources,
+				instance.requirements.begin() + (i + 1) * nb_resources);
+			act.successors.assign(instance.successors_begin(i), instance.successors_end(i));
+			act.predecessors.assign(_instance.predecessors_begin(i), _instance.predecessors_end(i));
 		}
 
 
@@ -195,51 +190,244 @@ namespace RCPSP
 	}
 
 
-	void Algorithm::check_solution()
+	bool Algorithm::check_solution()
 	{
+		_output.set_on(!_silent);
+		if (_best_activity_finish_times.size() != _activities.size())
+		{
+			_output << "\n\nCheck solution: no solution available";
+			return false;
+		}
+
 		bool ok = true;
-		std::cout << "\n";
+		_output << "\n";
 
-		// resource use
-		for (int t = 0; t < _upper_bound; ++t)
+		const int nb_activities = _instance.nb_activities;
+		const int nb_resources = _instance.nb_resources;
+		const std::vector<int>& finish = _best_activity_finish_times;
+
+		// start times
+		for (int i = 0; i < nb_activities; ++i)
 		{
-			for (int k = 0; k < _resource_availabilities.size(); ++k)
+			if (finish[i] - _instance.durations[i] < 0)
 			{
-				int resource_use = 0;
-				for (int i = 0; i < _activities.size(); ++i)
+				ok = false;
+				_output << "\nActivity " << i + 1 << " starts at time " << finish[i] - _instance.durations[i] << " < 0";
+			}
+		}
+
+		// resource use: sweep over the start and finish events in time order
+		// at equal times finish events come first, since an activity finishing at t no longer uses resources in period t
+		{
+			struct Event
+			{
+				int time;
+				int start; // 0 for a finish event, 1 for a start event
+				int activity;
+				bool operator<(const Event& other) const { return time < other.time || (time == other.time && start < other.start); }
+			};
+			std::vector<Event> events;
+			events.reserve(2 * static_cast<size_t>(nb_activities));
+			for (int i = 0; i < nb_activities; ++i)
+			{
+				if (_instance.durations[i] > 0)
 				{
-					if (_best_activity_finish_times[i] - _activities[i].duration >= t
-						&& _best_activity_finish_times[i] < t)
-					{
-						resource_use += _activities[i].resource_requirements[k];
-					}
+					events.push_back({ finish[i] - _instance.durations[i], 1, i });
+					events.push_back({ finish[i], 0, i });
 				}
+			}
+			std::sort(events.begin(), events.end());
+
+			std::vector<int> resource_use(nb_resources, 0);
+			std::vector<int> overload_since(nb_resources, -1);	// start of the current overloaded interval, -1 if none
+			std::vector<int> max_use(nb_resources, 0);			// maximum use within the current overloaded interval
 
-				if (resource_use > _resource_availabilities[k])
+			for (size_t e = 0; e < events.size(); )
+			{
+				// apply all events at this time
+				const int time = events[e].time;
+				for (; e < events.size() && events[e].time == time; ++e)
 				{
-					ok = false;
-					std::cout << "\nResource use in period " << t << " exceeds resource availabilities";
+					const int* req = _instance.requirements.data() + static_cast<size_t>(events[e].activity) * nb_resources;
+					const int sign = events[e].start ? 1 : -1;
+					for (int k = 0; k < nb_resources; ++k)
+						resource_use[k] += sign * req[k];
+				}
+
+				// the use is constant until the next event
+				for (int k = 0; k < nb_resources; ++k)
+				{
+					if (resource_use[k] > _resource_availabilities[k])
+					{
+						if (overload_since[k] < 0)
+						{
+							overload_since[k] = time;
+							max_use[k] = 0;
+						}
+						max_use[k] = std::max(max_use[k], resource_use[k]);
+					}
+					else if (overload_since[k] >= 0)
+					{
+						ok = false;
+						_output << "\nResource use of resource type " << k + 1 << " in periods [" << overload_since[k] << ", " << time
+							<< ") exceeds its availability (use " << max_use[k] << " > " << _resource_availabilities[k] << ")";
+						overload_since[k] = -1;
+					}
 				}
 			}
 		}
 
 		// precedences
-		for (int i = 0; i < _activities.size(); ++i)
+		for (int i = 0; i < nb_activities; ++i)
 		{
-			for (auto&& suc : _activities[i].successors)
+			for (const int* suc = _instance.successors_begin(i); suc != _instance.successors_end(i); ++suc)
 			{
-				if (_best_activity_finish_times[suc] - _activities[suc].duration < _best_activity_finish_times[i])
+				if (finish[*suc] - _instance.durations[*suc] < finish[i])
 				{
 					ok = false;
-					std::cout << "Activity " << i+1 << " finishes at time " << _best_activity_finish_times[i]
-						<< " but its successor " << suc + 1 << " already starts at time "
-							<< _best_activity_finish_times[suc] - _activities[suc].duration;
+					_output << "\nActivity " << i + 1 << " finishes at time " << finish[i]
+						<< " but its successor " << *suc + 1 << " already starts at time "
+						<< finish[*suc] - _instance.durations[*suc];
 				}
 			}
 		}
 
 		if (ok)
-			std::cout << "\nCheck solution: OK";
+			_output << "\nCheck solution: OK";
+		return ok;
+	}
+
+
+	void Algorithm::latest_start_activity_list(std::vector<int>& activity_list) const
+	{
+		// the eligible activity with the smallest latest start first
+		const int nb_activities = _instance.nb_activities;
+
+		std::vector<int> nb_unlisted_predecessors(nb_activities);
+		std::vector<std::pair<int, int>> eligible; // min-heap on (latest start, activity)
+		for (int i = 0; i < nb_activities; ++i)
+		{
+			nb_unlisted_predecessors[i] = _instance.predecessor_offsets[i + 1] - _instance.predecessor_offsets[i];
+			if (nb_unlisted_predecessors[i] == 0)
+				eligible.emplace_back(_instance.latest_start[i], i);
+		}
+		std::make_heap(eligible.begin(), eligible.end(), std::greater<>());
+
+		activity_list.clear();
+		activity_list.reserve(nb_activities);
+		while (!eligible.empty())
+		{
+			std::pop_heap(eligible.begin(), eligible.end(), std::greater<>());
+			const int j = eligible.back().second;
+			eligible.pop_back();
+			activity_list.push_back(j);
+
+			for (const int* suc = _instance.successors_begin(j); suc != _instance.successors_end(j); ++suc)
+				if (--nb_unlisted_predecessors[*suc] == 0)
+				{
+					eligible.emplace_back(_instance.latest_start[*suc], *suc);
+					std::push_heap(eligible.begin(), eligible.end(), std::greater<>());
+				}
+		}
+	}
+
+
+	void Algorithm::sample_activity_list(std::vector<int>& activity_list, std::mt19937_64& rng) const
+	{
+		// regret-based biased random sampling (Drexl, 1991): eligible activity j is chosen with a probability
+		// proportional to max_i LS_i - LS_j + 1 over the eligible activities i
+		const int nb_activities = _instance.nb_activities;
+
+		std::vector<int> nb_unlisted_predecessors(nb_activities);
+		std::vector<int> eligible;
+		for (int i = 0; i < nb_activities; ++i)
+		{
+			nb_unlisted_predecessors[i] = _instance.predecessor_offsets[i + 1] - _instance.predecessor_offsets[i];
+			if (nb_unlisted_predecessors[i] == 0)
+				eligible.push_back(i);
+		}
+
+		activity_list.clear();
+		activity_list.reserve(nb_activities);
+		while (!eligible.empty())
+		{
+			int max_latest_start = 0;
+			for (int i : eligible)
+				max_latest_start = std::max(max_latest_start, _instance.latest_start[i]);
+			int64_t total_weight = 0;
+			for (int i : eligible)
+				total_weight += max_latest_start - _instance.latest_start[i] + 1;
+
+			int64_t draw = std::uniform_int_distribution<int64_t>(0, total_weight - 1)(rng);
+			size_t e = 0;
+			for (; draw >= max_latest_start - _instance.latest_start[eligible[e]] + 1; ++e)
+				draw -= max_latest_start - _instance.latest_start[eligible[e]] + 1;
+
+			const int j = eligible[e];
+			eligible[e] = eligible.back();
+			eligible.pop_back();
+			activity_list.push_back(j);
+
+			for (const int* suc = _instance.successors_begin(j); suc != _instance.successors_end(j); ++suc)
+				if (--nb_unlisted_predecessors[*suc] == 0)
+					eligible.push_back(*suc);
+		}
+	}
+
+
+	void Algorithm::justify()
+	{
+		_justification_saving = 0;
+		if (!_solver_options.justify || _optimal || _best_activity_finish_times.size() != _activities.size())
+			return;
+
+		_output.set_on(!_silent);
+		const int makespan = *std::max_element(_best_activity_finish_times.begin(), _best_activity_finish_times.end());
+		Justification justification(_instance);
+		std::vector<int> finish_times = _best_activity_finish_times;
+		const int justified_makespan = justification.improve(finish_times.data());
+		_output << "\n\nDouble justification: makespan " << makespan << " -> " << justified_makespan;
+		if (justified_makespan < makespan)
+		{
+			_justification_saving = makespan - justified_makespan;
+			_best_activity_finish_times = finish_times;
+			_upper_bound = justified_makespan;
+			_optimal = (_upper_bound == _lower_bound);
+			_output << " (saved " << _justification_saving << ")";
+			_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		}
+	}
+
+
+	int Algorithm::heuristic_schedule(std::vector<int>& start_times) const
+	{
+		// serial schedule generation scheme with the latest start time as priority rule
+		std::vector<int> activity_list;
+		latest_start_activity_list(activity_list);
+
+		SGS sgs(_instance);
+		const int makespan = sgs.decode(activity_list, start_times);
+		for (int j = 0; j < _instance.nb_activities; ++j)
+			start_times[j] -= _instance.durations[j];
+		return makespan;
+	}
+
+
+	int Algorithm::simple_lower_bound() const
+	{
+		// critical path length
+		int bound = _instance.rcpl[0];
+
+		// total work per resource type divided by its availability
+		for (int k = 0; k < _instance.nb_resources; ++k)
+		{
+			int64_t work = 0;
+			for (int j = 0; j < _instance.nb_activities; ++j)
+				work += static_cast<int64_t>(_instance.durations[j]) * _instance.requirement(j, k);
+			if (_resource_availabilities[k] > 0)
+				bound = std::max(bound, static_cast<int>((work + _resource_availabilities[k] - 1) / _resource_availabilities[k]));
+		}
+		return bound;
 	}
 
 
@@ -256,6 +444,20 @@ namespace RCPSP
 			return std::make_unique<DH>();
 		else if (algorithm == "ip")
 			return std::make_unique<IP>();
+		else if (algorithm == "cpsat")
+			return std::make_unique<CPSAT>();
+		else if (algorithm == "eventip")
+			return std::make_unique<EventIP>();
+		else if (algorithm == "ga")
+			return std::make_unique<GA>();
+		else if (algorithm == "sa")
+			return std::make_unique<SA>();
+		else if (algorithm == "lns")
+			return std::make_unique<LNS>();
+		else if (algorithm == "sampling")
+			return std::make_unique<Sampling>();
+		else if (algorithm == "portfolio")
+			return std::make_unique<Portfolio>();
 		else
 			throw std::invalid_argument("No algorithm " + algorithm + " exists");
 	}
@@ -0,0 +1,139 @@
+#include "algorithms.h"
+#include "ortools/sat/cp_model.h"
+#include "ortools/sat/cp_model_solver.h"
+#include "ortools/sat/model.h"
+#include "ortools/util/time_limit.h"
+#include "ortools/sat/sat_parameters.pb.h"
+#include "google/protobuf/text_format.h"
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+
+
+namespace RCPSP
+{
+	void CPSAT::run(bool verbose)
+	{
+		namespace sat = operations_research::sat;
+
+		_output_screen = verbose && !_silent;
+		_output.set_on(!_silent);
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_lower_bound = 0;
+		_optimal = false;
+		_nb_nodes = 0;
+		_best_activity_finish_times.clear();
+
+		const int nb_activities = _instance.nb_activities;
+		const int nb_resources = _instance.nb_resources;
+
+
+		// the makespan of a heuristic schedule bounds the horizon, activity j can start in [ES_j, horizon - RCPL_j]
+		std::vector<int> heuristic_start_times;
+		const int horizon = heuristic_schedule(heuristic_start_times);
+
+		sat::CpModelBuilder model;
+		std::vector<sat::IntVar> start(nb_activities);
+		std::vector<sat::IntervalVar> interval(nb_activities);
+		for (int j = 0; j < nb_activities; ++j)
+		{
+			const int last_start = (j == 0) ? 0 : horizon - _instance.rcpl[j];
+			start[j] = model.NewIntVar(operations_research::Domain(_instance.earliest_start[j], last_start));
+			if (_instance.durations[j] > 0)
+				interval[j] = model.NewFixedSizeIntervalVar(start[j], _instance.durations[j]);
+			model.AddHint(start[j], heuristic_start_times[j]);
+		}
+
+		// precedence relations
+		for (int i = 0; i < nb_activities; ++i)
+			for (const int* suc = _instance.successors_begin(i); suc != _instance.successors_end(i); ++suc)
+				model.AddGreaterOrEqual(start[*suc], start[i] + _instance.durations[i]);
+
+		// resource constraints
+		for (int k = 0; k < nb_resources; ++k)
+		{
+			sat::CumulativeConstraint cumulative = model.AddCumulative(_resource_availabilities[k]);
+			for (int j = 0; j < nb_activities; ++j)
+				if (_instance.durations[j] > 0 && _instance.requirement(j, k) > 0)
+					cumulative.AddDemand(interval[j], _instance.requirement(j, k));
+		}
+
+		// makespan
+		sat::IntVar makespan = model.NewIntVar(operations_research::Domain(_instance.rcpl[0], horizon));
+		for (int j = 0; j < nb_activities; ++j)
+			if (_instance.nb_successors(j) == 0)
+				model.AddGreaterOrEqual(makespan, start[j] + _instance.durations[j]);
+		model.AddHint(makespan, horizon);
+		model.Minimize(makespan);
+
+
+		// parameters, the solver specific parameters first so that the other options take precedence
+		sat::SatParameters parameters;
+		if (!_solver_options.parameters.empty() && !google::protobuf::TextFormat::MergeFromString(_solver_options.parameters, &parameters))
+		{
+			throw std::invalid_argument("CP-SAT rejected the parameters " + _solver_options.parameters);
+		}
+		if (_solver_options.nb_workers > 0)
+			parameters.set_num_workers(_solver_options.nb_workers);
+		if (_solver_options.relative_gap >= 0)
+			parameters.set_relative_gap_limit(_solver_options.relative_gap);
+		if (!_solver_options.presolve)
+			parameters.set_cp_model_presolve(false);
+		if (_max_computation_time < std::numeric_limits<double>::infinity())
+			parameters.set_max_time_in_seconds(_max_computation_time);
+		parameters.set_log_search_progress(_output_screen);
+
+		_output << "\nUsing a CP-SAT model with an interval variable per activity and a cumulative constraint per resource type"
+			<< "\nHorizon (serial SGS) = " << horizon << ", ";
+		if (_solver_options.nb_workers > 0)
+			_output << _solver_options.nb_workers << " workers\n\n";
+		else
+			_output << "default number of workers\n\n";
+
+
+		// Solve the problem; in a portfolio, every schedule is shared and a proof of optimality by another algorithm stops the search
+		sat::Model sat_model;
+		sat_model.Add(sat::NewSatParameters(parameters));
+		if (_shared)
+		{
+			sat_model.Add(sat::NewFeasibleSolutionObserver([this](const sat::CpSolverResponse& solution) {
+				share_upper_bound(static_cast<int>(std::lround(solution.objective_value()))); }));
+			sat_model.GetOrCreate<operations_research::TimeLimit>()->RegisterExternalBooleanAsLimit(&_shared->stop);
+		}
+		auto start_time = std::chrono::steady_clock::now();
+		const sat::CpSolverResponse response = sat::SolveCpModel(model.Build(), &sat_model);
+		std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+		_output << "\nResult solve = " << sat::CpSolverStatus_Name(response.status());
+		_nb_nodes = static_cast<size_t>(response.num_branches());
+
+		// If optimal or feasible (e.g. time limit reached)
+		if (response.status() == sat::CpSolverStatus::OPTIMAL || response.status() == sat::CpSolverStatus::FEASIBLE)
+		{
+			_output << "\nElapsed time (s): " << elapsed_time.count();
+			_output << "\nMinimum project length = " << response.objective_value();
+			_upper_bound = static_cast<int>(std::lround(response.objective_value()));
+			_lower_bound = std::min(_upper_bound, static_cast<int>(std::ceil(response.best_objective_bound() - 1e-6)));
+			_optimal = (_lower_bound == _upper_bound);
+			share_upper_bound(_upper_bound);
+			share_lower_bound(_lower_bound);
+
+			_output << "\nActivity finish times:";
+			_best_activity_finish_times.resize(nb_activities);
+			for (int j = 0; j < nb_activities; ++j)
+			{
+				_best_activity_finish_times[j] = static_cast<int>(sat::SolutionIntegerValue(response, start[j])) + _instance.durations[j];
+				_output << "  f(" << j + 1 << ") = " << _best_activity_finish_times[j];
+			}
+		}
+		else
+		{
+			_output << "\nNo solution found";
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,408 @@
+#include "algorithms.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+
+
+namespace RCPSP
+{
+	void EventIP::build_problem()
+	{
+		const double infinity = std::numeric_limits<double>::infinity();
+		const int nb_activities = _instance.nb_activities;
+		const int nb_resources = _instance.nb_resources;
+		_model.clear();
+
+
+		// the activities of positive duration, each of them starts at one of the events
+		std::vector<int> index(nb_activities, -1); // [j] == a if activity j is _event_activities[a]
+		_event_activities.clear();
+		for (int j = 0; j < nb_activities; ++j)
+		{
+			if (_instance.durations[j] > 0)
+			{
+				index[j] = static_cast<int>(_event_activities.size());
+				_event_activities.push_back(j);
+			}
+		}
+		const int n = nb_events();
+
+		// topological order of all activities
+		std::vector<int> order;
+		std::vector<int> nb_unordered_predecessors(nb_activities);
+		order.reserve(nb_activities);
+		for (int j = 0; j < nb_activities; ++j)
+		{
+			nb_unordered_predecessors[j] = _instance.predecessor_offsets[j + 1] - _instance.predecessor_offsets[j];
+			if (nb_unordered_predecessors[j] == 0)
+				order.push_back(j);
+		}
+		for (size_t q = 0; q < order.size(); ++q)
+			for (const int* suc = _instance.successors_begin(order[q]); suc != _instance.successors_end(order[q]); ++suc)
+				if (--nb_unordered_predecessors[*suc] == 0)
+					order.push_back(*suc);
+
+		// precedence relations between the activities of positive duration, also through the activities without duration
+		std::vector<std::pair<int, int>> precedences; // (a, b): a precedes b
+		{
+			std::vector<int> visited(nb_activities, -1); // [j] == a if j was reached from _event_activities[a]
+			std::vector<int> stack;
+			for (int a = 0; a < n; ++a)
+			{
+				const int i = _event_activities[a];
+				stack.assign(_instance.successors_begin(i), _instance.successors_end(i));
+				while (!stack.empty())
+				{
+					const int j = stack.back();
+					stack.pop_back();
+					if (visited[j] == a)
+						continue;
+					visited[j] = a;
+
+					if (_instance.durations[j] > 0)
+						precedences.emplace_back(a, index[j]);
+					else
+						stack.insert(stack.end(), _instance.successors_begin(j), _instance.successors_end(j));
+				}
+			}
+		}
+
+		// event window [first_event[a], last_event[a]] in which activity a can be in progress: a chain of
+		// predecessors (successors) of positive duration occupies that many earlier (later) events
+		std::vector<int> chain_before(nb_activities, 0), chain_after(nb_activities, 0);
+		for (int j : order)
+			for (const int* suc = _instance.successors_begin(j); suc != _instance.successors_end(j); ++suc)
+				chain_before[*suc] = std::max(chain_before[*suc], chain_before[j] + (_instance.durations[j] > 0 ? 1 : 0));
+		for (auto it = order.rbegin(); it != order.rend(); ++it)
+			for (const int* suc = _instance.successors_begin(*it); suc != _instance.successors_end(*it); ++suc)
+				chain_after[*it] = std::max(chain_after[*it], chain_after[*suc] + (_instance.durations[*suc] > 0 ? 1 : 0));
+
+		std::vector<int> first_event(n), last_event(n);
+		for (int a = 0; a < n; ++a)
+		{
+			first_event[a] = chain_before[_event_activities[a]];
+			last_event[a] = n - 1 - chain_after[_event_activities[a]];
+		}
+
+
+		// variables z_ae, fixed at 0 outside the event window, event dates t_e and the makespan
+		for (int a = 0; a < n; ++a)
+			for (int e = 0; e < n; ++e)
+				_model.add_variable(0.0, (e >= first_event[a] && e <= last_event[a]) ? 1.0 : 0.0, true, { "z", _event_activities[a] + 1, e + 1 });
+		for (int e = 0; e < n; ++e)
+			_model.add_variable(0.0, (e == 0) ? 0.0 : _horizon, true, { "t", e + 1 });
+		const int Cmax = _model.add_variable(_instance.rcpl[0], _horizon, true, { "Cmax" });
+
+		// set objective function
+		_model.set_objective(Cmax, 1);
+
+
+
+		// add constraints
+		for (int a = 0; a < n; ++a)
+		{
+			const int j = _event_activities[a];
+			const int id = j + 1;
+			const int duration = _instance.durations[j];
+			const int first = first_event[a];
+			const int last = last_event[a];
+
+			// 1: every activity is in progress at some event
+			_model.add_row(1.0, infinity, { "c1", id });
+			for (int e = first; e <= last; ++e)
+				_model.add_term(z(a, e), 1);
+
+			for (int e = first; e <= last; ++e)
+			{
+				// 2: makespan, at least the remaining critical path length after the start event of a
+				_model.add_row(0.0, infinity, { "c2", id, e + 1 });
+				_model.add_term(Cmax, 1);
+				_model.add_term(t(e), -1);
+				_model.add_term(z(a, e), -_instance.rcpl[j]);
+				if (e > first)
+					_model.add_term(z(a, e - 1), _instance.rcpl[j]);
+
+				// 3: time window, a starts at event e between its earliest and latest start
+				if (_instance.earliest_start[j] > 0)
+				{
+					_model.add_row(0.0, infinity, { "c3", id, e + 1 });
+					_model.add_term(t(e), 1);
+					_model.add_term(z(a, e), -_instance.earliest_start[j]);
+				}
+				if (e > 0)
+				{
+					_model.add_row(-infinity, _horizon, { "c4", id, e + 1 });
+					_model.add_term(t(e), 1);
+					_model.add_term(z(a, e), _instance.rcpl[j]);
+					if (e > first)
+						_model.add_term(z(a, e - 1), -_instance.rcpl[j]);
+				}
+
+				// 5: duration, if a starts at event e and ends at event f, then t_f >= t_e + d_a
+				for (int f = e + 1; f <= std::min(last + 1, n - 1); ++f)
+				{
+					_model.add_row(-duration, infinity, { "c5", id, e + 1, f + 1 });
+					_model.add_term(t(f), 1);
+					_model.add_term(t(e), -1);
+					if (e > first)
+						_model.add_term(z(a, e - 1), duration);
+					if (f == e + 1)
+					{
+						_model.add_term(z(a, e), -2.0 * duration);
+					}
+					else
+					{
+						_model.add_term(z(a, e), -duration);
+						_model.add_term(z(a, f - 1), -duration);
+					}
+					if (f <= last)
+						_model.add_term(z(a, f), duration);
+				}
+
+				if (e == first)
+					continue;
+
+				// 6: contiguity, a is not in progress before the event at which it starts
+				_model.add_row(-infinity, e - first, { "c6", id, e + 1 });
+				for (int ee = first; ee < e - 1; ++ee)
+					_model.add_term(z(a, ee), 1);
+				_model.add_term(z(a, e - 1), 1 - (e - first));
+				_model.add_term(z(a, e), e - first);
+
+				// 7: contiguity, a is not in progress after the event at which it ends
+				const int nb_later = last - e + 1;
+				_model.add_row(-infinity, nb_later, { "c7", id, e + 1 });
+				_model.add_term(z(a, e), 1 - nb_later);
+				for (int ee = e + 1; ee <= last; ++ee)
+					_model.add_term(z(a, ee), 1);
+				_model.add_term(z(a, e - 1), nb_later);
+			}
+		}
+
+		// 8: precedence relations, if a is in progress at event e then b was not in progress at any event up to e
+		for (const auto& [a, b] : precedences)
+		{
+			for (int e = std::max(first_event[a], first_event[b]); e <= last_event[a]; ++e)
+			{
+				const int last = std::min(e, last_event[b]);
+				const int nb_terms = last - first_event[b] + 1;
+				_model.add_row(-infinity, nb_terms, { "c8", _event_activities[a] + 1, _event_activities[b] + 1, e + 1 });
+				_model.add_term(z(a, e), nb_terms);
+				for (int ee = first_event[b]; ee <= last; ++ee)
+					_model.add_term(z(b, ee), 1);
+			}
+		}
+
+		// 9: resource constraints, for the resource types that the activities together can overload
+		for (int k = 0; k < nb_resources; ++k)
+		{
+			int total_requirement = 0;
+			for (int a = 0; a < n; ++a)
+				total_requirement += _instance.requirement(_event_activities[a], k);
+			if (total_requirement <= _resource_availabilities[k])
+				continue;
+
+			for (int e = 0; e < n; ++e)
+			{
+				_model.add_row(-infinity, _resource_availabilities[k], { "c9", k + 1, e + 1 });
+				for (int a = 0; a < n; ++a)
+					if (e >= first_event[a] && e <= last_event[a] && _instance.requirement(_event_activities[a], k) > 0)
+						_model.add_term(z(a, e), _instance.requirement(_event_activities[a], k));
+			}
+		}
+
+		// 10: the events are in chronological order
+		for (int e = 1; e < n; ++e)
+		{
+			_model.add_row(0.0, infinity, { "c10", e + 1 });
+			_model.add_term(t(e), 1);
+			_model.add_term(t(e - 1), -1);
+		}
+
+
+
+		// create the solver (SCIP, CBC, CP-SAT, ...) and load the model
+		_solver = create_mip_solver(_solver_options);
+		_variables = _model.load(*_solver);
+
+		// write to file
+		if (!_model_file.empty())
+		{
+			_model.write(_model_file);
+			_output << "\nModel written to " << _model_file;
+		}
+	}
+
+	void EventIP::solve_problem()
+	{
+		const int n = nb_events();
+
+		_output << "\nUsing an on/off event-based MIP model with z_ae = 1 if activity a is in progress just after event e, 0 otherwise"
+			<< "\nUsing ORTools with " << _solver_options.mip_solver << " to solve the model ...";
+		_output << "\nWarm start from a heuristic schedule (serial SGS) with makespan " << _horizon
+			<< "\nModel with " << _solver->NumVariables() << " variables, " << _solver->NumConstraints() << " constraints, "
+			<< _model.nb_nonzeros() << " nonzeros\n\n";
+
+		// Output to screen
+		if (_output_screen)
+			_solver->EnableOutput();
+		else
+			_solver->SuppressOutput();
+
+		// Warm start: an event at the start of every activity of the heuristic schedule, in chronological order
+		{
+			std::vector<int> by_start(n);
+			for (int a = 0; a < n; ++a)
+				by_start[a] = a;
+			std::stable_sort(by_start.begin(), by_start.end(), [this](int a, int b) {
+				return _heuristic_start_times[_event_activities[a]] < _heuristic_start_times[_event_activities[b]]; });
+
+			std::vector<std::pair<const operations_research::MPVariable*, double>> hint;
+			hint.reserve(_variables.size());
+			for (int e = 0; e < n; ++e)
+			{
+				const int date = _heuristic_start_times[_event_activities[by_start[e]]];
+				hint.emplace_back(_variables[t(e)], date);
+				for (int a = 0; a < n; ++a)
+				{
+					const int start = _heuristic_start_times[_event_activities[a]];
+					const bool in_progress = (start <= date && date < start + _instance.durations[_event_activities[a]]);
+					hint.emplace_back(_variables[z(a, e)], in_progress ? 1.0 : 0.0);
+				}
+			}
+			hint.emplace_back(_variables[makespan_variable()], _horizon);
+			_solver->SetHint(std::move(hint));
+		}
+
+		// Set time limit (milliseconds)
+		if (_max_computation_time < std::numeric_limits<double>::infinity())
+		{
+			int64_t time_limit = static_cast<int64_t>(_max_computation_time * 1000);
+			_solver->set_time_limit(time_limit);
+		}
+
+		operations_research::MPSolverParameters parameters;
+		set_mip_options(*_solver, parameters, _solver_options, _output);
+
+		// Solve the problem
+		auto start_time = std::chrono::steady_clock::now();
+		const operations_research::MPSolver::ResultStatus result_status = _solver->Solve(parameters);
+		std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+		_output << "\nResult solve = " << static_cast<int>(result_status);
+		_nb_nodes = static_cast<size_t>(_solver->nodes());
+
+		// If optimal or feasible (e.g. time limit reached)
+		if (result_status == operations_research::MPSolver::OPTIMAL || result_status == operations_research::MPSolver::FEASIBLE)
+		{
+			_output << "\nElapsed time (s): " << elapsed_time.count();
+
+			// the start of an activity is the date of the first event at which it is in progress
+			std::vector<int> start_times(_instance.nb_activities, 0);
+			for (int a = 0; a < n; ++a)
+			{
+				for (int e = 0; e < n; ++e)
+				{
+					if (_variables[z(a, e)]->solution_value() > 0.5)
+					{
+						start_times[_event_activities[a]] = static_cast<int>(std::lround(_variables[t(e)]->solution_value()));
+						break;
+					}
+				}
+			}
+			complete_schedule(start_times);
+
+			_upper_bound = 0;
+			for (int j = 0; j < _instance.nb_activities; ++j)
+				_upper_bound = std::max(_upper_bound, start_times[j] + _instance.durations[j]);
+			// with a relative gap, OPTIMAL only means that the gap was reached
+			if (result_status == operations_research::MPSolver::OPTIMAL && _solver_options.relative_gap <= 0)
+				_lower_bound = _upper_bound;
+			else
+				_lower_bound = std::min(_upper_bound, static_cast<int>(std::ceil(_solver->Objective().BestBound() - 1e-6)));
+			_lower_bound = std::max(_lower_bound, _instance.rcpl[0]);
+			_optimal = (_lower_bound == _upper_bound);
+			report_schedule(start_times);
+		}
+		else
+		{
+			// no incumbent within the time limit: fall back on the heuristic schedule
+			_output << "\nNo IP solution found, reporting the heuristic schedule";
+			_upper_bound = _horizon;
+			_lower_bound = _instance.rcpl[0];
+			report_schedule(_heuristic_start_times);
+		}
+	}
+
+	void EventIP::complete_schedule(std::vector<int>& start_times) const
+	{
+		// the activities without duration start as soon as their predecessors finish, in topological order
+		std::vector<int> nb_unscheduled_predecessors(_instance.nb_activities);
+		std::vector<int> order;
+		order.reserve(_instance.nb_activities);
+		for (int j = 0; j < _instance.nb_activities; ++j)
+		{
+			nb_unscheduled_predecessors[j] = _instance.predecessor_offsets[j + 1] - _instance.predecessor_offsets[j];
+			if (nb_unscheduled_predecessors[j] == 0)
+				order.push_back(j);
+		}
+		for (size_t q = 0; q < order.size(); ++q)
+		{
+			const int j = order[q];
+			if (_instance.durations[j] == 0)
+			{
+				start_times[j] = 0;
+				for (const int* pred = _instance.predecessors_begin(j); pred != _instance.predecessors_end(j); ++pred)
+					start_times[j] = std::max(start_times[j], start_times[*pred] + _instance.durations[*pred]);
+			}
+			for (const int* suc = _instance.successors_begin(j); suc != _instance.successors_end(j); ++suc)
+				if (--nb_unscheduled_predecessors[*suc] == 0)
+					order.push_back(*suc);
+		}
+	}
+
+	void EventIP::report_schedule(const std::vector<int>& start_times)
+	{
+		_optimal = (_lower_bound == _upper_bound);
+
+		_output << "\nMinimum project length = " << _upper_bound;
+		_output << "\nActivity finish times:";
+		_best_activity_finish_times.resize(_instance.nb_activities);
+		for (int j = 0; j < _instance.nb_activities; ++j)
+		{
+			_best_activity_finish_times[j] = start_times[j] + _instance.durations[j];
+			_output << "  f(" << j + 1 << ") = " << _best_activity_finish_times[j];
+		}
+	}
+
+	void EventIP::run(bool verbose)
+	{
+		_output_screen = verbose && !_silent;
+		_output.set_on(!_silent);
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_lower_bound = 0;
+		_optimal = false;
+		_nb_nodes = 0;
+		_root_bound = 0;
+		_best_activity_finish_times.clear();
+
+		// warm start, a heuristic schedule that reaches the critical path length is optimal
+		_horizon = heuristic_schedule(_heuristic_start_times);
+		if (_horizon == _instance.rcpl[0])
+		{
+			_output << "\nThe heuristic schedule reaches the critical path length and is optimal";
+			_upper_bound = _lower_bound = _horizon;
+			report_schedule(_heuristic_start_times);
+			return;
+		}
+
+		build_problem();
+		solve_problem();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,235 @@
+#include "algorithms.h"
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+
+
+namespace RCPSP
+{
+	void GA::crossover(const Individual& mother, const Individual& father, Individual& child, int first, int last, Worker& worker) const
+	{
+		// two-point crossover: positions [0, first) from the mother, [first, last) the remaining activities in the order
+		// of the father, [last, n) the remaining activities in the order of the mother; the child is precedence feasible
+		// when both parents are
+		const int nb_activities = _instance.nb_activities;
+		std::fill(worker.listed.begin(), worker.listed.end(), 0);
+		child.activity_list.resize(nb_activities);
+
+		int position = 0;
+		for (; position < first; ++position)
+		{
+			const int j = mother.activity_list[position];
+			child.activity_list[position] = j;
+			worker.listed[j] = 1;
+		}
+		for (int i = 0; position < last; ++i)
+		{
+			const int j = father.activity_list[i];
+			if (!worker.listed[j])
+			{
+				child.activity_list[position++] = j;
+				worker.listed[j] = 1;
+			}
+		}
+		for (int i = 0; position < nb_activities; ++i)
+		{
+			const int j = mother.activity_list[i];
+			if (!worker.listed[j])
+			{
+				child.activity_list[position++] = j;
+				worker.listed[j] = 1;
+			}
+		}
+	}
+
+
+	void GA::mutate(Individual& individual, Worker& worker) const
+	{
+		// swap neighbouring activities that are not precedence related
+		std::bernoulli_distribution mutation(_mutation_probability);
+		std::vector<int>& list = individual.activity_list;
+		for (size_t i = 0; i + 1 < list.size(); ++i)
+			if (mutation(worker.rng) && !_instance.precedes(list[i], list[i + 1]))
+				std::swap(list[i], list[i + 1]);
+	}
+
+
+	int GA::evaluate(Individual& individual, Worker& worker) const
+	{
+		// the justified schedule replaces the list by the one that decodes into it
+		individual.makespan = worker.sgs.decode(individual.activity_list.data(), worker.finish_times.data());
+		if (_solver_options.justify)
+			individual.makespan = worker.justification.improve(worker.finish_times.data(), individual.activity_list.data());
+		return individual.makespan;
+	}
+
+
+	void GA::create_children(Worker& worker, int first_pair, int last_pair)
+	{
+		const int nb_activities = _instance.nb_activities;
+		std::uniform_int_distribution<int> cut(1, std::max(nb_activities - 1, 1));
+
+		for (int p = first_pair; p < last_pair; ++p)
+		{
+			const Individual& mother = _individuals[_parents[2 * p]];
+			const Individual& father = _individuals[_parents[2 * p + 1]];
+			int first = cut(worker.rng);
+			int last = cut(worker.rng);
+			if (first > last)
+				std::swap(first, last);
+
+			Individual& daughter = _individuals[_population_size + 2 * p];
+			Individual& son = _individuals[_population_size + 2 * p + 1];
+			crossover(mother, father, daughter, first, last, worker);
+			crossover(father, mother, son, first, last, worker);
+			for (Individual* child : { &daughter, &son })
+			{
+				mutate(*child, worker);
+				evaluate(*child, worker);
+			}
+		}
+	}
+
+
+	void GA::search(int nb_threads)
+	{
+		// The threads work in phases: the main thread prepares a phase, every thread (the main thread included) runs the
+		// task of the phase on its share of the work, and the main thread continues when all of them have finished
+		std::function<void(int)> task;
+		bool stop = false;
+		std::barrier sync(nb_threads);
+		std::vector<std::thread> threads;
+		for (int w = 1; w < nb_threads; ++w)
+		{
+			threads.emplace_back([&, w]() {
+				for (;;)
+				{
+					sync.arrive_and_wait();
+					if (stop)
+						return;
+					task(w);
+					sync.arrive_and_wait();
+				}
+				});
+		}
+		auto run_phase = [&](std::function<void(int)> phase) {
+			task = std::move(phase);
+			sync.arrive_and_wait();
+			task(0);
+			sync.arrive_and_wait();
+		};
+		auto share = [nb_threads](int size, int w) { return static_cast<int>(static_cast<int64_t>(size) * w / nb_threads); };
+
+
+		// initial population: the latest start list and lists sampled with a bias towards small latest starts
+		_individuals.assign(2 * static_cast<size_t>(_population_size), Individual());
+		latest_start_activity_list(_individuals[0].activity_list);
+		evaluate(_individuals[0], _workers[0]);
+		run_phase([&](int w) {
+			for (int i = 1 + share(_population_size - 1, w); i < 1 + share(_population_size - 1, w + 1); ++i)
+			{
+				_individuals[i].activity_list.clear();
+				sample_activity_list(_individuals[i].activity_list, _workers[w].rng);
+				evaluate(_individuals[i], _workers[w]);
+			}
+			});
+		// a justified schedule counts as three schedules, as in the literature
+		const size_t schedules_per_individual = _solver_options.justify ? 3 : 1;
+		_nb_schedules = _population_size * schedules_per_individual;
+		std::stable_sort(_individuals.begin(), _individuals.begin() + _population_size,
+			[](const Individual& a, const Individual& b) { return a.makespan < b.makespan; });
+		_output << "\nInitial population: best makespan " << _individuals[0].makespan;
+
+
+		// generations
+		std::seed_seq seed{ _solver_options.seed };
+		std::mt19937_64 rng(seed);
+		_parents.resize(_population_size);
+		const int nb_pairs = _population_size / 2;
+		while (_nb_schedules < _max_schedules && _individuals[0].makespan > _lower_bound
+			&& std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count() < _max_computation_time)
+		{
+			// pair the parents at random
+			for (int i = 0; i < _population_size; ++i)
+				_parents[i] = i;
+			std::shuffle(_parents.begin(), _parents.end(), rng);
+
+			run_phase([&](int w) { create_children(_workers[w], share(nb_pairs, w), share(nb_pairs, w + 1)); });
+			_nb_schedules += 2 * static_cast<size_t>(nb_pairs) * schedules_per_individual;
+			++_nb_generations;
+
+			// ranking selection: the best of the parents and children survive, the others are the buffers of the next children
+			const int best = _individuals[0].makespan;
+			std::stable_sort(_individuals.begin(), _individuals.end(),
+				[](const Individual& a, const Individual& b) { return a.makespan < b.makespan; });
+			if (_individuals[0].makespan < best)
+				_output << "\nGeneration " << _nb_generations << ": makespan " << _individuals[0].makespan << " after " << _nb_schedules << " schedules";
+		}
+
+		stop = true;
+		sync.arrive_and_wait();
+		for (auto&& thread : threads)
+			thread.join();
+	}
+
+
+	void GA::run(bool verbose)
+	{
+		_verbose = verbose && !_silent;
+		_output.set_on(!_silent);
+		_output << "\nStarting genetic algorithm ...\n";
+		_output.set_on(_verbose);
+
+		_start_time = std::chrono::steady_clock::now();
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_optimal = false;
+		_best_activity_finish_times.clear();
+		_nb_schedules = 0;
+		_nb_generations = 0;
+
+		const int nb_threads = (_solver_options.nb_workers > 0) ? _solver_options.nb_workers
+			: std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+		if (_solver_options.max_schedules > 0)
+			_max_schedules = _solver_options.max_schedules;
+		_lower_bound = simple_lower_bound();
+
+		_workers.resize(nb_threads);
+		for (int w = 0; w < nb_threads; ++w)
+		{
+			_workers[w].sgs.reset(_instance);
+			if (_solver_options.justify)
+				_workers[w].justification.reset(_instance);
+			std::seed_seq seed{ _solver_options.seed, static_cast<unsigned int>(w) + 1 };
+			_workers[w].rng.seed(seed);
+			_workers[w].finish_times.resize(_instance.nb_activities);
+			_workers[w].listed.resize(_instance.nb_activities);
+		}
+		_output << "\nPopulation " << _population_size << ", " << nb_threads << " threads, seed " << _solver_options.seed
+			<< ", at most " << _max_schedules << " schedules" << (_solver_options.justify ? ", double justification" : "");
+
+		// Main procedure
+		search(nb_threads);
+
+		// The best individual
+		_upper_bound = _workers[0].sgs.decode(_individuals[0].activity_list, _best_activity_finish_times);
+		_optimal = (_upper_bound == _lower_bound);
+		_nb_nodes = _nb_schedules;
+
+		// Print statistics
+		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::steady_clock::now() - _start_time;
+		_output.set_on(!_silent);
+		if (_optimal)
+			_output << "\n\n\nOptimal solution found with makespan " << _upper_bound;
+		else
+			_output << "\n\n\nBest solution found has makespan " << _upper_bound << " (lower bound " << _lower_bound << ")";
+		_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		_output << "\n\nElapsed time (s): " << elapsed_time.count();
+		_output << "\nSchedules generated: " << _nb_schedules;
+		_output << "\nGenerations: " << _nb_generations;
+	}
+}
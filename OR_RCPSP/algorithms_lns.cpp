@@ -0,0 +1,285 @@
+#include "algorithms.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+
+
+namespace RCPSP
+{
+	void LNS::build_subproject(const std::vector<int>& order, const std::vector<int>& finish_times, int first, int last,
+		Instance& subproject, std::vector<int>& index) const
+	{
+		// The block order[first, last) is freed. The subproject starts at the start time t of order[first] and contains
+		// - the activities that started earlier and are still in progress at t, for the rest of their duration,
+		// - the freed activities, with the precedence relations among them (transitively reduced),
+		// - a chain of activities without resource requirements that finish at the release dates r > 0 of the freed
+		//   activities (the latest finish time of their predecessors outside the block, minus t); the activity that finishes
+		//   at r precedes the freed activities with release date r. A chain keeps only one of them in progress at a time,
+		//   which matters to DH, whose branching enumerates subsets of the activities in progress.
+		// and a dummy start and end activity. index[j] receives the activity of the subproject of freed activity j.
+		const int nb_resources = _instance.nb_resources;
+		const int time = finish_times[order[first]] - _instance.durations[order[first]];
+
+		subproject.clear();
+		subproject.nb_resources = nb_resources;
+		subproject.resource_availabilities = _instance.resource_availabilities;
+		std::vector<std::vector<int>> successors;
+		auto add_activity = [&](int duration, int original) {
+			subproject.durations.push_back(duration);
+			for (int k = 0; k < nb_resources; ++k)
+				subproject.requirements.push_back(original >= 0 ? _instance.requirement(original, k) : 0);
+			successors.emplace_back();
+			return subproject.nb_activities++;
+		};
+
+		add_activity(0, -1); // dummy start
+		for (int n = 0; n < first; ++n)
+		{
+			const int i = order[n];
+			if (_instance.durations[i] > 0 && finish_times[i] > time)
+			{
+				const int in_progress = add_activity(finish_times[i] - time, i);
+				successors[0].push_back(in_progress);
+			}
+		}
+
+		std::fill(index.begin(), index.end(), -1);
+		for (int n = first; n < last; ++n)
+			index[order[n]] = add_activity(_instance.durations[order[n]], order[n]);
+
+		std::map<int, std::vector<int>> released; // release date -> freed activities of the subproject
+		for (int n = first; n < last; ++n)
+		{
+			const int j = order[n];
+			int release = 0;
+			bool freed_predecessor = false;
+			for (const int* pred = _instance.predecessors_begin(j); pred != _instance.predecessors_end(j); ++pred)
+			{
+				if (index[*pred] >= 0)
+					freed_predecessor = true;
+				else
+					release = std::max(release, finish_times[*pred] - time);
+			}
+
+			if (release > 0)
+				released[release].push_back(index[j]);
+			else if (!freed_predecessor)
+				successors[0].push_back(index[j]);
+
+			for (int m = n + 1; m < last; ++m)
+			{
+				const int k = order[m];
+				if (!_instance.precedes(j, k))
+					continue;
+				bool implied = false;
+				for (int l = n + 1; l < m && !implied; ++l)
+					implied = _instance.precedes(j, order[l]) && _instance.precedes(order[l], k);
+				if (!implied)
+					successors[index[j]].push_back(index[k]);
+			}
+		}
+
+		int previous = 0, previous_release = 0;
+		for (auto&& [release, activities] : released)
+		{
+			const int release_activity = add_activity(release - previous_release, -1);
+			successors[previous].push_back(release_activity);
+			successors[release_activity] = activities;
+			previous = release_activity;
+			previous_release = release;
+		}
+
+		const int dummy_end = add_activity(0, -1);
+		for (int i = 0; i < dummy_end; ++i)
+			if (successors[i].empty())
+				successors[i].push_back(dummy_end);
+
+		subproject.successor_offsets.assign(1, 0);
+		for (auto&& s : successors)
+		{
+			subproject.successors.insert(subproject.successors.end(), s.begin(), s.end());
+			subproject.successor_offsets.push_back(static_cast<int>(subproject.successors.size()));
+		}
+		subproject.build_predecessors();
+	}
+
+
+	void LNS::repair(int thread)
+	{
+		const int nb_activities = _instance.nb_activities;
+		std::seed_seq seed{ _solver_options.seed, static_cast<unsigned int>(thread) + 1 };
+		std::mt19937_64 rng(seed);
+
+		std::string repair_name = _solver_options.lns_repair;
+		std::unique_ptr<Algorithm> repair = AlgorithmFactory::create(repair_name);
+		SolverOptions repair_options = _solver_options;
+		repair_options.nb_workers = 1;
+		repair_options.justify = false;
+		repair->set_solver_options(repair_options);
+		repair->set_silent(true);
+
+		SGS sgs(_instance);
+		Justification justification;
+		if (_solver_options.justify)
+			justification.reset(_instance);
+
+		Instance subproject;
+		std::vector<int> order, finish_times(nb_activities), start_times(nb_activities), index(nb_activities);
+		std::vector<std::pair<int, int>> freed; // (start in the subproject, position in the block)
+		int size = std::min(_solver_options.lns_size, nb_activities - 2);
+
+		for (;;)
+		{
+			const double remaining = _max_computation_time - std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count();
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_stop || remaining <= 0 || _best_makespan <= _lower_bound || (_max_repairs > 0 && _nb_repairs >= _max_repairs))
+					return;
+				order = _best_activity_list;
+			}
+
+			// the list in order of start time decodes into the same schedule or a shorter one
+			sgs.decode(order.data(), finish_times.data());
+			for (int j = 0; j < nb_activities; ++j)
+				start_times[j] = finish_times[j] - _instance.durations[j];
+			std::stable_sort(order.begin(), order.end(), [&start_times](int a, int b) { return start_times[a] < start_times[b]; });
+
+			// free a random block of activities, without the dummies
+			const int first = std::uniform_int_distribution<int>(1, std::max(nb_activities - 1 - size, 1))(rng);
+			const int last = std::min(first + size, nb_activities - 1);
+			build_subproject(order, finish_times, first, last, subproject, index);
+
+			repair->set_max_time(std::min(_repair_time, remaining));
+			repair->load_instance(subproject);
+			repair->run(false);
+			const std::vector<int>& repaired = repair->finish_times();
+
+			// the order of the freed activities in the repaired subproject, ties in the order of the block
+			int makespan = std::numeric_limits<int>::max();
+			if (!repaired.empty())
+			{
+				freed.clear();
+				for (int n = first; n < last; ++n)
+					freed.emplace_back(repaired[index[order[n]]] - _instance.durations[order[n]], n);
+				std::sort(freed.begin(), freed.end());
+				std::vector<int> block(last - first);
+				for (int n = 0; n < last - first; ++n)
+					block[n] = order[freed[n].second];
+				std::copy(block.begin(), block.end(), order.begin() + first);
+
+				makespan = sgs.decode(order.data(), finish_times.data());
+				if (_solver_options.justify)
+					makespan = justification.improve(finish_times.data(), order.data());
+			}
+
+			// larger neighbourhoods while the repair finishes in time, much smaller ones when it does not
+			if (repair->optimal())
+				size = std::min(size + 1, nb_activities - 2);
+			else
+				size = std::max(size * 3 / 4, 2);
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			++_nb_repairs;
+			if (repair->optimal())
+				++_nb_optimal_repairs;
+			if (makespan <= _best_makespan)
+			{
+				if (makespan < _best_makespan)
+				{
+					++_nb_improvements;
+					_output << "\nRepair " << _nb_repairs << " (thread " << thread << ", activities " << first << " to " << last - 1
+						<< " of the start time order): makespan " << makespan;
+				}
+				_best_activity_list = order;
+				_best_makespan = makespan;
+			}
+		}
+	}
+
+
+	void LNS::run(bool verbose)
+	{
+		_verbose = verbose && !_silent;
+		_output.set_on(!_silent);
+		_output << "\nStarting large neighbourhood search ...\n";
+		_output.set_on(_verbose);
+
+		_start_time = std::chrono::steady_clock::now();
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_optimal = false;
+		_best_activity_finish_times.clear();
+		_nb_repairs = 0;
+		_nb_improvements = 0;
+		_nb_optimal_repairs = 0;
+
+		std::string repair_name = _solver_options.lns_repair;
+		std::transform(repair_name.begin(), repair_name.end(), repair_name.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (repair_name != "dh" && repair_name != "cpsat")
+		{
+			throw std::invalid_argument("Unknown LNS repair algorithm " + _solver_options.lns_repair + " (use DH or CPSAT)");
+		}
+		_stop = false;
+		const int nb_threads = (_solver_options.nb_workers > 0) ? _solver_options.nb_workers
+			: std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+		_max_repairs = _solver_options.max_schedules;
+		_lower_bound = simple_lower_bound();
+
+		// start from the latest start list
+		latest_start_activity_list(_best_activity_list);
+		{
+			SGS sgs(_instance);
+			std::vector<int> finish_times;
+			_best_makespan = sgs.decode(_best_activity_list, finish_times);
+		}
+		_output << "\nRepair with " << _solver_options.lns_repair << ", " << _repair_time << " s per repair, neighbourhoods of "
+			<< _solver_options.lns_size << " activities, " << nb_threads << " threads";
+		_output << "\nInitial schedule: makespan " << _best_makespan;
+
+		// Main procedure
+		std::exception_ptr error;
+		std::vector<std::thread> threads;
+		for (int w = 0; w < nb_threads; ++w)
+		{
+			threads.emplace_back([this, w, &error]() {
+				try
+				{
+					repair(w);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (!error)
+						error = std::current_exception();
+					_stop = true;
+				}
+				});
+		}
+		for (auto&& thread : threads)
+			thread.join();
+		if (error)
+			std::rethrow_exception(error);
+
+		// The best schedule
+		SGS sgs(_instance);
+		_upper_bound = sgs.decode(_best_activity_list, _best_activity_finish_times);
+		_optimal = (_upper_bound == _lower_bound);
+		_nb_nodes = _nb_repairs;
+
+		// Print statistics
+		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::steady_clock::now() - _start_time;
+		_output.set_on(!_silent);
+		if (_optimal)
+			_output << "\n\n\nOptimal solution found with makespan " << _upper_bound;
+		else
+			_output << "\n\n\nBest solution found has makespan " << _upper_bound << " (lower bound " << _lower_bound << ")";
+		_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		_output << "\n\nElapsed time (s): " << elapsed_time.count();
+		_output << "\nRepairs: " << _nb_repairs << " (" << _nb_optimal_repairs << " solved to optimality, " << _nb_improvements << " improvements)";
+	}
+}
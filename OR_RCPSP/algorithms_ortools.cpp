@@ -1,180 +1,295 @@
 #include "algorithms.h"
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include <iostream>
-#include <fstream>
 #include <chrono>
+#include <cctype>
+#include <cmath>
+#include <thread>
 
 
 
 namespace RCPSP
 {
-	void IP::build_problem()
+	std::unique_ptr<operations_research::MPSolver> create_mip_solver(const SolverOptions& options)
 	{
-		// create the solver (_solver_type == SCIP or CPLEX or ...)
-		_solver.reset(operations_research::MPSolver::CreateSolver(_solver_type));
+		std::string solver_id = options.mip_solver;
+		std::transform(solver_id.begin(), solver_id.end(), solver_id.begin(), [](unsigned char c) { return std::toupper(c); });
+		if (solver_id == "CP-SAT" || solver_id == "CPSAT" || solver_id == "CP_SAT")
+			solver_id = "SAT";
 
+		std::unique_ptr<operations_research::MPSolver> solver(operations_research::MPSolver::CreateSolver(solver_id));
+		if (!solver)
+		{
+			throw std::invalid_argument("The MIP solver " + options.mip_solver + " is not available in this build of OR-Tools");
+		}
+		return solver;
+	}
 
-		// add variables
-		size_t max_periods = 0;
-		for (auto&& d : _activities)
-			max_periods += d.duration;
-		const double infinity = _solver->infinity();
+	void set_mip_options(operations_research::MPSolver& solver, operations_research::MPSolverParameters& parameters,
+		const SolverOptions& options, Output& output)
+	{
+		if (options.relative_gap >= 0)
+			parameters.SetDoubleParam(operations_research::MPSolverParameters::RELATIVE_MIP_GAP, options.relative_gap);
+		if (!options.presolve)
+			parameters.SetIntegerParam(operations_research::MPSolverParameters::PRESOLVE, operations_research::MPSolverParameters::PRESOLVE_OFF);
+		if (options.nb_workers > 0 && !solver.SetNumThreads(options.nb_workers).ok())
+			output << "\nThe MIP solver " << options.mip_solver << " does not support multiple threads";
+		if (!options.parameters.empty() && !solver.SetSolverSpecificParametersAsString(options.parameters))
+		{
+			throw std::invalid_argument("The MIP solver " + options.mip_solver + " rejected the parameters " + options.parameters);
+		}
+	}
 
+	///////////////////////////////////////////////////////////////////////////
 
-		// variables x_jt
-		for (auto j = 0; j < _activities.size(); ++j)
+	void IP::build_problem()
+	{
+		const double infinity = std::numeric_limits<double>::infinity();
+		const int nb_activities = _instance.nb_activities;
+		const int nb_resources = _instance.nb_resources;
+		_model.clear();
+
+
+		// start windows: the makespan of the heuristic schedule bounds the horizon,
+		// activity j can start in [ES_j, horizon - RCPL_j]; the dummy start is fixed at 0
+		_first_start.resize(nb_activities);
+		_x_offsets.resize(nb_activities + 1);
+		_x_offsets[0] = 0;
+		for (int j = 0; j < nb_activities; ++j)
 		{
-			for (auto t = 0; t < max_periods; ++t)
-			{
-				std::string varname = "x_" + std::to_string(j + 1) + "_" + std::to_string(t + 1);
-				operations_research::MPVariable* var = _solver->MakeBoolVar(varname);
-			}
+			_first_start[j] = _instance.earliest_start[j];
+			int last = (j == 0) ? 0 : _horizon - _instance.rcpl[j];
+			_x_offsets[j + 1] = _x_offsets[j] + (last - _first_start[j] + 1);
 		}
 
-		// variable Z
+
+		// variables x_jt, named only when the model is exported
+		const int nb_x = _x_offsets[nb_activities];
+		size_t nb_precedences = 0, nb_precedence_terms = 0;
+		int max_window = 0;
+		for (int i = 0; i < nb_activities; ++i)
 		{
-			std::string varname = "Z";
-			operations_research::MPVariable* var = _solver->MakeNumVar(0.0, infinity, varname);
+			max_window = std::max(max_window, last_start(i) - first_start(i) + 1);
+			for (const int* suc = _instance.successors_begin(i); suc != _instance.successors_end(i); ++suc)
+			{
+				const size_t nb_terms = (last_start(i) - first_start(i) + 1) + (last_start(*suc) - first_start(*suc) + 1);
+				const size_t nb_rows = _disaggregated ? (last_start(*suc) - first_start(*suc) + 1) : 1;
+				nb_precedences += nb_rows;
+				nb_precedence_terms += nb_rows * nb_terms;
+			}
 		}
+		_model.reserve(nb_x + 1, 2 * nb_activities + nb_precedences, 2 * static_cast<size_t>(nb_x) + nb_precedence_terms);
+
+		for (int j = 0; j < nb_activities; ++j)
+			for (int t = first_start(j); t <= last_start(j); ++t)
+				_model.add_variable(0.0, 1.0, true, { "x", j + 1, t + 1 });
+		_model.set_bounds(x(0, 0), 1.0, 1.0);
+
+		// variable Z, between the critical path length and the makespan of the heuristic schedule
+		const int Z = _model.add_variable(_instance.rcpl[0], _horizon, false, { "Z" });
 
 
 		// set objective function
-		operations_research::MPObjective* objective = _solver->MutableObjective();
-		objective->SetMinimization();
-		{ // Z variable
-			operations_research::MPVariable* var = _solver->variable(_activities.size() * max_periods);
-			objective->SetCoefficient(var, 1);
-		}
+		_model.set_objective(Z, 1);
+
+
+		// the coefficients of a row are assembled here and added in bulk
+		std::vector<int> columns(2 * static_cast<size_t>(max_window) + 1);
+		std::vector<double> values(2 * static_cast<size_t>(max_window) + 1);
 
 
 
 		// add constraints
-		int nb_constraints = -1;
 
 		// 1: every activity starts exactly once
-		for (auto j = 0; j < _activities.size(); ++j)
+		std::fill(values.begin(), values.end(), 1.0);
+		for (int j = 0; j < nb_activities; ++j)
 		{
-			++nb_constraints;
+			_model.add_row(1.0, 1.0, { "c1", j + 1 });
 
-			std::string conname = "c1_" + std::to_string(j + 1);
-			operations_research::MPConstraint* constraint = _solver->MakeRowConstraint(1.0, 1.0, conname);
-
-			// x_jt
-			for (auto t = 0; t < max_periods; ++t)
-			{
-				size_t index_var = j * max_periods + t;
-				operations_research::MPVariable* var = _solver->variable(index_var);
-				constraint->SetCoefficient(var, 1);
-			}
+			const int nb_terms = last_start(j) - first_start(j) + 1;
+			for (int e = 0; e < nb_terms; ++e)
+				columns[e] = x(j, first_start(j)) + e;
+			_model.add_terms(columns.data(), values.data(), nb_terms);
 		}
 
-		// 2: precedence relations
-		for (auto i = 0; i < _activities.size(); ++i)
+		// 2: precedence relations, unless the windows already imply them
+		// aggregated:		sum_t t x_st - sum_t t x_it >= d_i
+		// disaggregated:	sum_{tau <= t} x_s,tau - sum_{tau <= t - d_i} x_i,tau <= 0 for every period t in which s can start
+		//					before i surely finishes; more rows, but a much tighter LP relaxation
+		for (int i = 0; i < nb_activities; ++i)
 		{
-			for (auto&& suc : _activities[i].successors)
+			const int duration = _instance.durations[i];
+			for (const int* suc = _instance.successors_begin(i); suc != _instance.successors_end(i); ++suc)
 			{
-				++nb_constraints;
+				if (last_start(i) + duration <= first_start(*suc))
+					continue;
 
-				std::string conname = "c2_" + std::to_string(i + 1) + "_" + std::to_string(suc + 1);
-				operations_research::MPConstraint* constraint = _solver->MakeRowConstraint(_activities[i].duration, infinity, conname);
-
-				// x_jt
-				for (auto t = 0; t < max_periods; ++t)
+				if (_disaggregated)
 				{
-					size_t index_var = suc * max_periods + t;
-					operations_research::MPVariable* var = _solver->variable(index_var);
-					constraint->SetCoefficient(var, t);
+					const int last = std::min(last_start(*suc), last_start(i) + duration - 1);
+					for (int t = first_start(*suc); t <= last; ++t)
+					{
+						_model.add_row(-infinity, 0.0, { "c2", i + 1, *suc + 1, t + 1 });
+
+						size_t nb_terms = 0;
+						for (int tau = first_start(*suc); tau <= t; ++tau, ++nb_terms)
+						{
+							columns[nb_terms] = x(*suc, tau);
+							values[nb_terms] = 1;
+						}
+						for (int tau = first_start(i); tau <= t - duration; ++tau, ++nb_terms)
+						{
+							columns[nb_terms] = x(i, tau);
+							values[nb_terms] = -1;
+						}
+						_model.add_terms(columns.data(), values.data(), nb_terms);
+					}
+					continue;
 				}
 
-				// x_it
-				for (auto t = 0; t < max_periods; ++t)
+				_model.add_row(duration, infinity, { "c2", i + 1, *suc + 1 });
+
+				size_t nb_terms = 0;
+				for (int t = std::max(first_start(*suc), 1); t <= last_start(*suc); ++t, ++nb_terms)
+				{
+					columns[nb_terms] = x(*suc, t);
+					values[nb_terms] = t;
+				}
+				for (int t = std::max(first_start(i), 1); t <= last_start(i); ++t, ++nb_terms)
 				{
-					size_t index_var = i * max_periods + t;
-					operations_research::MPVariable* var = _solver->variable(index_var);
-					constraint->SetCoefficient(var, -t);
+					columns[nb_terms] = x(i, t);
+					values[nb_terms] = -t;
 				}
+				_model.add_terms(columns.data(), values.data(), nb_terms);
 			}
 		}
 
-		// 3: resource constraints
-		for (auto k = 0; k < _resource_availabilities.size(); ++k)
-		{
-			for (auto t = 0; t < max_periods; ++t)
+		// 3: resource constraints, only for the periods in which the activities that can be in progress
+		// together exceed the availability; every resource type is assembled in its own block of rows
+		auto build_resource_rows = [this](int k, LinearModel::Rows& rows) {
+			const double infinity = std::numeric_limits<double>::infinity();
+			std::vector<int> candidates;	// activities requiring resource type k, by first start
+			std::vector<int> in_progress;	// candidates that can be in progress in period t
+			for (int j = 0; j < _instance.nb_activities; ++j)
+				if (_instance.requirement(j, k) > 0 && _instance.durations[j] > 0)
+					candidates.push_back(j);
+			std::sort(candidates.begin(), candidates.end(), [this](int a, int b) { return _first_start[a] < _first_start[b]; });
+
+			size_t next = 0;
+			for (int t = 0; t < _horizon; ++t)
 			{
-				++nb_constraints;
+				for (; next < candidates.size() && first_start(candidates[next]) <= t; ++next)
+					in_progress.push_back(candidates[next]);
+				in_progress.erase(std::remove_if(in_progress.begin(), in_progress.end(),
+					[this, t](int j) { return last_start(j) + _instance.durations[j] <= t; }), in_progress.end());
 
-				std::string conname = "c3_" + std::to_string(k + 1) + "_" + std::to_string(t + 1);
-				operations_research::MPConstraint* constraint = _solver->MakeRowConstraint(-infinity, _resource_availabilities[k], conname);
+				int max_use = 0;
+				for (int j : in_progress)
+					max_use += _instance.requirement(j, k);
+				if (max_use <= _resource_availabilities[k])
+					continue;
 
 				// x_jtau
-				for (auto j = 0; j < _activities.size(); ++j)
+				rows.add(-infinity, _resource_availabilities[k], { "c3", k + 1, t + 1 });
+				for (int j : in_progress)
 				{
-					for (auto tau = std::max(t - _activities[j].duration + 1, 0); tau <= t; ++tau)
-					{
-						size_t index_var = j * max_periods + tau;
-						operations_research::MPVariable* var = _solver->variable(index_var);
-						constraint->SetCoefficient(var, _activities[j].resource_requirements[k]);
-					}
+					const int last = std::min(t, last_start(j));
+					const double requirement = _instance.requirement(j, k);
+					for (int tau = std::max(t - _instance.durations[j] + 1, first_start(j)); tau <= last; ++tau)
+						rows.add_term(x(j, tau), requirement);
 				}
 			}
-		}
+		};
 
-		// 4: makespan constraints
-		for (auto j = 0; j < _activities.size(); ++j)
+		// the threads of the MIP solver also assemble the resource rows, one resource type at a time
+		const int nb_build_threads = std::min(std::max(_solver_options.nb_workers, 1), nb_resources);
+		if (nb_build_threads > 1)
 		{
-			++nb_constraints;
-
-			std::string conname = "c4_" + std::to_string(j + 1);
-			operations_research::MPConstraint* constraint = _solver->MakeRowConstraint(_activities[j].duration, infinity, conname);
-
-			// x_jt
-			for (auto t = 0; t < max_periods; ++t)
+			std::vector<LinearModel::Rows> blocks(nb_resources);
+			std::atomic<int> next_resource{ 0 };
+			auto worker = [&]() {
+				for (int k = next_resource++; k < nb_resources; k = next_resource++)
+					build_resource_rows(k, blocks[k]);
+			};
+			std::vector<std::thread> threads;
+			for (int w = 1; w < nb_build_threads; ++w)
+				threads.emplace_back(worker);
+			worker();
+			for (auto&& thread : threads)
+				thread.join();
+
+			for (auto&& block : blocks)
+				_model.add_rows(block);
+		}
+		else
+		{
+			LinearModel::Rows block;
+			for (int k = 0; k < nb_resources; ++k)
 			{
-				size_t index_var = j * max_periods + t;
-				operations_research::MPVariable* var = _solver->variable(index_var);
-				constraint->SetCoefficient(var, -t);
+				block.clear();
+				build_resource_rows(k, block);
+				_model.add_rows(block);
 			}
+		}
 
-			// Z
+		// 4: makespan constraints, for the activities without successors
+		for (int j = 0; j < nb_activities; ++j)
+		{
+			if (_instance.nb_successors(j) > 0)
+				continue;
+
+			_model.add_row(_instance.durations[j], infinity, { "c4", j + 1 });
+
+			size_t nb_terms = 0;
+			for (int t = std::max(first_start(j), 1); t <= last_start(j); ++t, ++nb_terms)
 			{
-				size_t index_var = _activities.size() * max_periods;
-				operations_research::MPVariable* var = _solver->variable(index_var);
-				constraint->SetCoefficient(var, 1);
+				columns[nb_terms] = x(j, t);
+				values[nb_terms] = -t;
 			}
+			columns[nb_terms] = Z;
+			values[nb_terms++] = 1;
+			_model.add_terms(columns.data(), values.data(), nb_terms);
 		}
 
 
 
+		// create the solver (SCIP, CBC, CP-SAT, ...) and load the model
+		_solver = create_mip_solver(_solver_options);
+		_variables = _model.load(*_solver);
 
 		// write to file
-		//_solver->Write("SCIP1.lp"); // NOT YET SUPPORTED
-
+		if (!_model_file.empty())
 		{
-			std::ofstream mfile("ORTools_IP.lp");
-			mfile << "Obj\t";
-			for (auto& var : _solver->variables())
-			{
-				if (_solver->Objective().GetCoefficient(var) > 0.00001 || _solver->Objective().GetCoefficient(var) < -0.00001)
-					mfile << _solver->Objective().GetCoefficient(var) << " " << var->name() << " + ";
-			}
-
-			for (auto& con : _solver->constraints())
-			{
-				mfile << "\n\n" << con->name() << "\t" << con->lb() << " <=  ";
-				for (auto& var : _solver->variables())
-				{
-					if (con->GetCoefficient(var) > 0.00001 || con->GetCoefficient(var) < -0.00001)
-						mfile << con->GetCoefficient(var) << " " << var->name() << " + ";
-				}
-				mfile << "  <= " << con->ub();
-			}
+			_model.write(_model_file);
+			_output << "\nModel written to " << _model_file;
 		}
 	}
 
-	void IP::solve_problem()
+	void IP::solve_relaxation()
 	{
-		std::cout << "\nUsing an IP model with x_jk = 1 if activity j starts at time t, 0 otherwise"
-			<< "\nUsing ORTools with SCIP to solve the model ...\n\n";
+		// the LP relaxation of the same model, solved with GLOP
+		std::unique_ptr<operations_research::MPSolver> lp_solver(operations_research::MPSolver::CreateSolver("GLOP"));
+		if (!lp_solver)
+			return;
+		_model.load(*lp_solver, true);
+		if (_max_computation_time < std::numeric_limits<double>::infinity())
+			lp_solver->set_time_limit(static_cast<int64_t>(std::max(remaining_time(), 0.0) * 1000));
+
+		if (lp_solver->Solve() == operations_research::MPSolver::OPTIMAL)
+			_root_bound = lp_solver->Objective().Value();
+	}
+
+	void IP::prepare_solver(operations_research::MPSolverParameters& parameters)
+	{
+		_output << "\nUsing an IP model with x_jk = 1 if activity j starts at time t, 0 otherwise, and "
+			<< (_disaggregated ? "disaggregated" : "aggregated") << " precedence constraints"
+			<< "\nUsing ORTools with " << _solver_options.mip_solver << " to solve the model ...";
+		_output << "\nWarm start and horizon from a heuristic schedule (serial SGS) with makespan " << _horizon
+			<< "\nModel with " << _solver->NumVariables() << " variables, " << _solver->NumConstraints() << " constraints, "
+			<< _model.nb_nonzeros() << " nonzeros\n\n";
 
 		// Output to screen
 		if (_output_screen)
@@ -182,56 +297,219 @@ namespace RCPSP
 		else
 			_solver->SuppressOutput();
 
+		set_mip_options(*_solver, parameters, _solver_options, _output);
+	}
+
+	void IP::solve_problem()
+	{
+		operations_research::MPSolverParameters parameters;
+		prepare_solver(parameters);
+
+		// Warm start: the heuristic schedule as a complete solution hint
+		{
+			std::vector<std::pair<const operations_research::MPVariable*, double>> hint;
+			hint.reserve(_variables.size());
+			for (int j = 0; j < _instance.nb_activities; ++j)
+				for (int t = first_start(j); t <= last_start(j); ++t)
+					hint.emplace_back(_variables[x(j, t)], (t == _heuristic_start_times[j]) ? 1.0 : 0.0);
+			hint.emplace_back(_variables.back(), _horizon); // Z
+			_solver->SetHint(std::move(hint));
+		}
+
 		// Set time limit (milliseconds) 
-		int64_t time_limit = static_cast<int64_t>(_max_computation_time * 1000);
-		_solver->set_time_limit(time_limit);
+		if (_max_computation_time < std::numeric_limits<double>::infinity())
+		{
+			int64_t time_limit = static_cast<int64_t>(std::max(remaining_time(), 0.0) * 1000);
+			_solver->set_time_limit(time_limit);
+		}
 
 		// Solve the problem
 		auto start_time = std::chrono::system_clock::now();
-		const operations_research::MPSolver::ResultStatus result_status = _solver->Solve();
+		const operations_research::MPSolver::ResultStatus result_status = _solver->Solve(parameters);
 		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time_IP = std::chrono::system_clock::now() - start_time;
 
-		std::cout << "\nResult solve = " << result_status;
+		_output << "\nResult solve = " << static_cast<int>(result_status);
+		_nb_nodes = static_cast<size_t>(_solver->nodes());
 
 		// If optimal or feasible (e.g. time limit reached)
 		if (result_status == operations_research::MPSolver::OPTIMAL || result_status == operations_research::MPSolver::FEASIBLE)
 		{
-			double objval = _solver->Objective().Value();
+			_output << "\nElapsed time (s): " << elapsed_time_IP.count();
+
+			std::vector<int> start_times;
+			_upper_bound = read_schedule(start_times);
+			// with a relative gap, OPTIMAL only means that the gap was reached
+			if (result_status == operations_research::MPSolver::OPTIMAL && _solver_options.relative_gap <= 0)
+				_lower_bound = _upper_bound;
+			else
+				_lower_bound = std::min(_upper_bound, static_cast<int>(std::ceil(_solver->Objective().BestBound() - 1e-6)));
+			_lower_bound = std::max({ _lower_bound, _instance.rcpl[0], static_cast<int>(std::ceil(_root_bound - 1e-6)) });
+			_optimal = (_lower_bound == _upper_bound);
+			report_schedule(start_times);
+		}
+		else
+		{
+			// no incumbent within the time limit: fall back on the heuristic schedule
+			_output << "\nNo IP solution found, reporting the heuristic schedule";
+			use_heuristic_schedule();
+		}
+	}
 
-			std::cout << "\nElapsed time (s): " << elapsed_time_IP.count();
-			std::cout << "\nMinimum project length = " << objval;
-			_upper_bound = objval;
+	void IP::search_horizon()
+	{
+		operations_research::MPSolverParameters parameters;
+		prepare_solver(parameters);
+		_output << "Iterative horizon tightening: every trial horizon T is a feasibility problem with makespan <= T\n";
+
+		// without objective the solver stops at the first schedule
+		operations_research::MPVariable* Z = _variables.back();
+		_solver->MutableObjective()->SetCoefficient(Z, 0);
+
+		std::vector<int> best_start_times = _heuristic_start_times;
+		std::vector<int> start_times;
+		int upper_bound = _horizon;
+		int lower_bound = std::max(_instance.rcpl[0], static_cast<int>(std::ceil(_root_bound - 1e-6)));
+		bool first_trial = true;
+
+		auto start_time = std::chrono::steady_clock::now();
+		while (lower_bound < upper_bound)
+		{
+			if (remaining_time() <= 0)
+				break;
+			if (_max_computation_time < std::numeric_limits<double>::infinity())
+				_solver->set_time_limit(static_cast<int64_t>(remaining_time() * 1000));
+
+			// first try the lower bound, which is often tight, then bisect
+			const int horizon = first_trial ? lower_bound : lower_bound + (upper_bound - lower_bound - 1) / 2;
+			first_trial = false;
+
+			// restrict the windows to the trial horizon through the bounds of the variables only,
+			// and hint the starts of the incumbent that still fit
+			std::vector<std::pair<const operations_research::MPVariable*, double>> hint;
+			for (int j = 0; j < _instance.nb_activities; ++j)
+			{
+				const int last = horizon - _instance.rcpl[j];
+				for (int t = first_start(j); t <= last_start(j); ++t)
+					_variables[x(j, t)]->SetUB((t <= last) ? 1.0 : 0.0);
+				if (best_start_times[j] <= last)
+					hint.emplace_back(_variables[x(j, best_start_times[j])], 1.0);
+			}
+			Z->SetUB(horizon);
+			_solver->SetHint(std::move(hint));
 
-			size_t max_periods = 0;
-			for (auto&& d : _activities)
-				max_periods += d.duration;
+			const operations_research::MPSolver::ResultStatus result_status = _solver->Solve(parameters);
+			_nb_nodes += static_cast<size_t>(_solver->nodes());
 
-			std::cout << "\nActivity finish times:";
-			_best_activity_finish_times.clear();
-			_best_activity_finish_times.reserve(_activities.size());
-			for (auto j = 0; j < _activities.size(); ++j)
+			_output << "\nHorizon " << horizon << ": ";
+			if (result_status == operations_research::MPSolver::OPTIMAL || result_status == operations_research::MPSolver::FEASIBLE)
 			{
-				for (auto t = 0; t < max_periods; ++t)
-				{
-					operations_research::MPVariable* var = _solver->variable(j * max_periods + t);
-					double solvalue = var->solution_value();
+				upper_bound = read_schedule(start_times);
+				best_start_times.swap(start_times);
+				_output << "schedule with makespan " << upper_bound;
+			}
+			else if (result_status == operations_research::MPSolver::INFEASIBLE)
+			{
+				lower_bound = horizon + 1;
+				_output << "infeasible";
+			}
+			else
+			{
+				_output << "no result within the time limit";
+				break;
+			}
+		}
 
-					if (solvalue > 0.99)
-					{
-						std::cout << "  f(" << j + 1 << ") = " << t + _activities[j].duration;
-						_best_activity_finish_times.push_back(t + _activities[j].duration);
-					}
+		std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+		_output << "\n\nElapsed time (s): " << elapsed_time.count();
+
+		_upper_bound = upper_bound;
+		_lower_bound = lower_bound;
+		_optimal = (_lower_bound == _upper_bound);
+		report_schedule(best_start_times);
+	}
+
+	int IP::read_schedule(std::vector<int>& start_times) const
+	{
+		int makespan = 0;
+		start_times.assign(_instance.nb_activities, 0);
+		for (int j = 0; j < _instance.nb_activities; ++j)
+		{
+			for (int t = first_start(j); t <= last_start(j); ++t)
+			{
+				if (_variables[x(j, t)]->solution_value() > 0.99)
+				{
+					start_times[j] = t;
+					break;
 				}
 			}
+			makespan = std::max(makespan, start_times[j] + _instance.durations[j]);
+		}
+		return makespan;
+	}
+
+	void IP::report_schedule(const std::vector<int>& start_times)
+	{
+		_output << "\nMinimum project length = " << _upper_bound;
+		_output << "\nActivity finish times:";
+		_best_activity_finish_times.resize(_instance.nb_activities);
+		for (int j = 0; j < _instance.nb_activities; ++j)
+		{
+			_best_activity_finish_times[j] = start_times[j] + _instance.durations[j];
+			_output << "  f(" << j + 1 << ") = " << _best_activity_finish_times[j];
 		}
 	}
 
+	void IP::use_heuristic_schedule()
+	{
+		_upper_bound = _horizon;
+		_lower_bound = std::max(_instance.rcpl[0], static_cast<int>(std::ceil(_root_bound - 1e-6)));
+		_optimal = (_upper_bound == _lower_bound);
+		report_schedule(_heuristic_start_times);
+	}
+
 	void IP::run(bool verbose)
 	{
-		_output_screen = verbose;
+		_output_screen = verbose && !_silent;
+		_output.set_on(!_silent);
+
+		// Reset the results of a previous run
+		_start_time = std::chrono::steady_clock::now();
+		_upper_bound = std::numeric_limits<int>::max();
+		_lower_bound = 0;
+		_optimal = false;
+		_nb_nodes = 0;
+		_root_bound = 0;
+		_best_activity_finish_times.clear();
+
+		if (_solver_options.formulation != "aggregated" && _solver_options.formulation != "disaggregated")
+		{
+			throw std::invalid_argument("Unknown IP formulation " + _solver_options.formulation + " (use aggregated or disaggregated)");
+		}
+		_disaggregated = (_solver_options.formulation == "disaggregated");
+
+		// warm start, a heuristic schedule that reaches the critical path length is optimal
+		_horizon = heuristic_schedule(_heuristic_start_times);
+		if (_horizon == _instance.rcpl[0])
+		{
+			_output << "\nThe heuristic schedule reaches the critical path length and is optimal";
+			use_heuristic_schedule();
+			return;
+		}
 
 		build_problem();
-		solve_problem();
+		solve_relaxation();
+		if (_solver_options.horizon_search)
+			search_horizon();
+		else
+			solve_problem();
+
+		// strength of the formulation
+		if (_root_bound > 0)
+		{
+			_output << "\n\nLP relaxation bound = " << _root_bound
+				<< ", root gap = " << 100.0 * (_upper_bound - _root_bound) / _upper_bound << "%"
+				<< ", nodes = " << _nb_nodes;
+		}
 	}
 
 	///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,114 @@
+#include "algorithms.h"
+#include <chrono>
+#include <exception>
+#include <thread>
+
+
+
+namespace RCPSP
+{
+	void Portfolio::run(bool verbose)
+	{
+		_verbose = verbose && !_silent;
+		_output.set_on(!_silent);
+		_output << "\nStarting portfolio of DH, CP-SAT and simulated annealing ...\n";
+
+		const auto start_time = std::chrono::steady_clock::now();
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_optimal = false;
+		_nb_nodes = 0;
+		_best_activity_finish_times.clear();
+
+		// every engine on its own copy of the project, silent, with the time limit of the portfolio
+		SharedBounds shared;
+		shared.lower_bound = simple_lower_bound();
+		_engines.clear();
+		for (const char* name : { "DH", "CPSAT", "SA" })
+		{
+			std::string algorithm = name;
+			Engine engine;
+			engine.name = name;
+			engine.algorithm = AlgorithmFactory::create(algorithm);
+			engine.algorithm->set_solver_options(_solver_options);
+			engine.algorithm->set_max_time(_max_computation_time);
+			engine.algorithm->set_silent(true);
+			engine.algorithm->set_shared_bounds(&shared);
+			engine.algorithm->load_instance(_instance);
+			_engines.push_back(std::move(engine));
+		}
+
+
+		// Race: an engine that proves the optimum sets the stop flag of the shared bounds, which the others check
+		std::mutex mutex;
+		std::exception_ptr error;
+		std::vector<std::thread> threads;
+		for (auto&& engine : _engines)
+		{
+			threads.emplace_back([&engine, &shared, &mutex, &error]() {
+				const auto engine_start = std::chrono::steady_clock::now();
+				try
+				{
+					engine.algorithm->run(false);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!error)
+						error = std::current_exception();
+					shared.stop = true;
+				}
+				engine.elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - engine_start).count();
+				});
+		}
+		for (auto&& thread : threads)
+			thread.join();
+		if (error)
+			std::rethrow_exception(error);
+
+
+		// The best schedule of the engines, of the first to finish on a tie, and the best bound that any of them has proven
+		const Engine* best = nullptr;
+		for (auto&& engine : _engines)
+		{
+			_nb_nodes += engine.algorithm->nb_nodes();
+			if (!engine.algorithm->finish_times().empty() && (!best
+				|| std::make_pair(engine.algorithm->makespan(), engine.elapsed_time) < std::make_pair(best->algorithm->makespan(), best->elapsed_time)))
+				best = &engine;
+		}
+		if (best)
+		{
+			_upper_bound = best->algorithm->makespan();
+			_best_activity_finish_times = best->algorithm->finish_times();
+		}
+		_lower_bound = std::min(shared.lower_bound.load(), _upper_bound);
+		_optimal = best && (_upper_bound == _lower_bound);
+
+		// Print statistics
+		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::steady_clock::now() - start_time;
+		if (!best)
+		{
+			_output << "\n\n\nNo solution found within the time limit";
+		}
+		else
+		{
+			if (_optimal)
+				_output << "\n\n\nOptimal solution found with makespan " << _upper_bound << " (" << best->name << ")";
+			else
+				_output << "\n\n\nBest solution found has makespan " << _upper_bound << " (" << best->name << ", lower bound " << _lower_bound << ")";
+			_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		}
+		_output << "\n\nElapsed time (s): " << elapsed_time.count();
+		for (auto&& engine : _engines)
+		{
+			_output << "\n" << engine.name << ": ";
+			if (engine.algorithm->finish_times().empty())
+				_output << "no schedule";
+			else
+				_output << "makespan " << engine.algorithm->makespan();
+			_output << ", lower bound " << engine.algorithm->lower_bound() << (engine.algorithm->optimal() ? " (optimal)" : "")
+				<< ", " << engine.elapsed_time << " s, " << engine.algorithm->nb_nodes() << " nodes";
+		}
+	}
+}
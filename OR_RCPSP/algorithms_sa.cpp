@@ -0,0 +1,215 @@
+#include "algorithms.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+
+
+namespace RCPSP
+{
+	int SA::shift(std::vector<int>& activity_list, int from, std::mt19937_64& rng) const
+	{
+		// the activity can move anywhere between its last predecessor and its first successor in the list
+		const int activity = activity_list[from];
+		int first = from;
+		while (first > 0 && !_instance.precedes(activity_list[first - 1], activity))
+			--first;
+		int last = from;
+		while (last + 1 < static_cast<int>(activity_list.size()) && !_instance.precedes(activity, activity_list[last + 1]))
+			++last;
+
+		const int to = std::uniform_int_distribution<int>(first, last)(rng);
+		if (to < from)
+			std::rotate(activity_list.begin() + to, activity_list.begin() + from, activity_list.begin() + from + 1);
+		else
+			std::rotate(activity_list.begin() + from, activity_list.begin() + from + 1, activity_list.begin() + to + 1);
+		return to;
+	}
+
+
+	int SA::swap(std::vector<int>& activity_list, int from, std::mt19937_64& rng) const
+	{
+		// the activity can trade places with an activity before its first successor that does not succeed any activity
+		// in between; returns from if the drawn partner does not qualify
+		const int activity = activity_list[from];
+		int last = from;
+		while (last + 1 < static_cast<int>(activity_list.size()) && !_instance.precedes(activity, activity_list[last + 1]))
+			++last;
+		if (last == from)
+			return from;
+
+		const int to = std::uniform_int_distribution<int>(from + 1, last)(rng);
+		const int other = activity_list[to];
+		for (int i = from + 1; i < to; ++i)
+			if (_instance.precedes(activity_list[i], other))
+				return from;
+
+		std::swap(activity_list[from], activity_list[to]);
+		return to;
+	}
+
+
+	void SA::search()
+	{
+		const int nb_activities = _instance.nb_activities;
+		std::seed_seq seed{ _solver_options.seed };
+		std::mt19937_64 rng(seed);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		std::uniform_int_distribution<int> position(1, std::max(nb_activities - 2, 1)); // the dummies stay in place
+
+		SGS sgs(_instance);
+		Justification justification;
+		if (_solver_options.justify)
+			justification.reset(_instance);
+
+		// start from the latest start list
+		std::vector<int> activity_list;
+		latest_start_activity_list(activity_list);
+		std::vector<int> finish_times(nb_activities);
+		std::vector<int> justified(nb_activities);
+		int makespan = sgs.decode(activity_list.data(), finish_times.data());
+		_best_activity_list = activity_list;
+		_best_makespan = makespan;
+		share_upper_bound(_best_makespan);
+
+		// geometric cooling from half the mean duration to a hundredth of that over the schedules of the run
+		int nb_positive = 0;
+		double total_duration = 0;
+		for (int j = 0; j < nb_activities; ++j)
+			if (_instance.durations[j] > 0)
+			{
+				++nb_positive;
+				total_duration += _instance.durations[j];
+			}
+		const double initial_temperature = std::max(0.5 * total_duration / std::max(nb_positive, 1), 0.1);
+		const double cooling = std::pow(0.01, 1.0 / static_cast<double>(_max_schedules));
+		double temperature = initial_temperature;
+		const size_t restart_moves = 20 * static_cast<size_t>(nb_activities);
+		size_t moves_since_improvement = 0;
+
+		while (nb_activities > 3 && _nb_schedules < _max_schedules && _best_makespan > _lower_bound
+			&& ((_nb_schedules & 255) != 0 || (std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count() < _max_computation_time
+				&& !shared_stop())))
+		{
+			temperature *= cooling;
+			++_nb_schedules;
+
+			const int from = position(rng);
+			const bool shift_move = uniform(rng) < 0.5;
+			const int to = shift_move ? shift(activity_list, from, rng) : swap(activity_list, from, rng);
+			if (to == from)
+				continue;
+
+			// only the list from the first changed position on is decoded again
+			const int first_changed = std::min(from, to);
+			const int new_makespan = sgs.decode(activity_list.data(), finish_times.data(), first_changed);
+			_nb_positions_decoded += nb_activities - first_changed;
+
+			const int delta = new_makespan - makespan;
+			if (delta <= 0 || uniform(rng) < std::exp(-delta / temperature))
+			{
+				++_nb_accepted;
+				makespan = new_makespan;
+				if (makespan < _best_makespan)
+				{
+					if (_solver_options.justify)
+					{
+						// continue from the list of the justified schedule, which replaces the list even when it is not
+						// shorter, so the schedule and the resource profile of the SGS are those of the new list
+						std::copy(finish_times.begin(), finish_times.end(), justified.begin());
+						justification.improve(justified.data(), activity_list.data());
+						makespan = sgs.decode(activity_list.data(), finish_times.data());
+						_nb_positions_decoded += nb_activities;
+					}
+					_best_activity_list = activity_list;
+					_best_makespan = makespan;
+					share_upper_bound(_best_makespan);
+					moves_since_improvement = 0;
+					_output << "\nSchedule " << _nb_schedules << ": makespan " << _best_makespan << " (temperature " << temperature << ")";
+					continue;
+				}
+			}
+			else
+			{
+				// undo the move
+				if (shift_move)
+				{
+					if (to < from)
+						std::rotate(activity_list.begin() + to, activity_list.begin() + to + 1, activity_list.begin() + from + 1);
+					else
+						std::rotate(activity_list.begin() + from, activity_list.begin() + to, activity_list.begin() + to + 1);
+				}
+				else
+				{
+					std::swap(activity_list[from], activity_list[to]);
+				}
+				sgs.decode(activity_list.data(), finish_times.data(), first_changed);
+				_nb_positions_decoded += nb_activities - first_changed;
+			}
+
+			// back to the best list when the search has drifted away for too long
+			if (++moves_since_improvement >= restart_moves)
+			{
+				activity_list = _best_activity_list;
+				makespan = sgs.decode(activity_list.data(), finish_times.data());
+				_nb_positions_decoded += nb_activities;
+				moves_since_improvement = 0;
+			}
+		}
+	}
+
+
+	void SA::run(bool verbose)
+	{
+		_verbose = verbose && !_silent;
+		_output.set_on(!_silent);
+		_output << "\nStarting simulated annealing ...\n";
+		_output.set_on(_verbose);
+
+		_start_time = std::chrono::steady_clock::now();
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_optimal = false;
+		_best_activity_finish_times.clear();
+		_nb_schedules = 0;
+		_nb_accepted = 0;
+		_nb_positions_decoded = 0;
+
+		if (_solver_options.max_schedules > 0)
+			_max_schedules = _solver_options.max_schedules;
+		_lower_bound = simple_lower_bound();
+		_output << "\nSeed " << _solver_options.seed << ", at most " << _max_schedules << " moves"
+			<< (_solver_options.justify ? ", double justification of improving schedules" : "");
+
+		// Main procedure
+		search();
+
+		// The best schedule
+		SGS sgs(_instance);
+		_upper_bound = sgs.decode(_best_activity_list, _best_activity_finish_times);
+		if (_upper_bound != _best_makespan)
+		{
+			// the search has shared _best_makespan, so it has to be the makespan of the list it reports
+			throw std::logic_error("The best activity list of SA decodes to makespan " + std::to_string(_upper_bound)
+				+ " instead of " + std::to_string(_best_makespan));
+		}
+		_optimal = (_upper_bound == _lower_bound);
+		_nb_nodes = _nb_schedules;
+
+		// Print statistics
+		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::steady_clock::now() - _start_time;
+		_output.set_on(!_silent);
+		if (_optimal)
+			_output << "\n\n\nOptimal solution found with makespan " << _upper_bound;
+		else
+			_output << "\n\n\nBest solution found has makespan " << _upper_bound << " (lower bound " << _lower_bound << ")";
+		_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		_output << "\n\nElapsed time (s): " << elapsed_time.count();
+		_output << "\nMoves: " << _nb_schedules << " (" << _nb_accepted << " accepted)";
+		if (_nb_schedules > 0)
+			_output << "\nAverage part of the list decoded per move: "
+			<< 100.0 * static_cast<double>(_nb_positions_decoded) / (static_cast<double>(_nb_schedules) * _instance.nb_activities) << "%";
+	}
+}
@@ -0,0 +1,136 @@
+#include "algorithms.h"
+#include <chrono>
+#include <exception>
+#include <thread>
+
+
+
+namespace RCPSP
+{
+	void Sampling::sample(int thread, size_t nb_passes)
+	{
+		const int nb_activities = _instance.nb_activities;
+		std::seed_seq seed{ _solver_options.seed, static_cast<unsigned int>(thread) + 1 };
+		std::mt19937_64 rng(seed);
+
+		SGS serial(_instance);
+		ParallelSGS parallel(_instance);
+		Justification justification;
+		if (_solver_options.justify)
+			justification.reset(_instance);
+		std::vector<int> activity_list, finish_times(nb_activities);
+
+		for (size_t pass = 0; pass < nb_passes && _best_makespan.load() > _lower_bound; ++pass)
+		{
+			if (std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count() > _max_computation_time || shared_stop())
+				return;
+
+			// the parallel SGS generates non-delay schedules, which need not include an optimal one; the serial SGS
+			// generates active schedules, which do
+			const bool parallel_pass = (pass % 2 == 0);
+			int makespan = 0;
+			if (parallel_pass)
+			{
+				makespan = parallel.sample(_instance.latest_start.data(), rng, finish_times.data());
+			}
+			else
+			{
+				sample_activity_list(activity_list, rng);
+				makespan = serial.decode(activity_list.data(), finish_times.data());
+			}
+			if (_solver_options.justify)
+				makespan = justification.improve(finish_times.data());
+			++_nb_passes;
+
+			if (makespan > _best_makespan.load())
+				continue;
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (std::make_tuple(makespan, thread, pass) < _best)
+			{
+				if (makespan < std::get<0>(_best))
+					_output << "\nPass " << pass << " of thread " << thread << " (" << (parallel_pass ? "parallel" : "serial") << " SGS): makespan " << makespan;
+				_best = std::make_tuple(makespan, thread, pass);
+				_best_parallel = parallel_pass;
+				_best_activity_finish_times = finish_times;
+				_best_makespan = makespan;
+				share_upper_bound(makespan);
+			}
+		}
+	}
+
+
+	void Sampling::run(bool verbose)
+	{
+		_verbose = verbose && !_silent;
+		_output.set_on(!_silent);
+		_output << "\nStarting multi-pass sampling ...\n";
+		_output.set_on(_verbose);
+
+		_start_time = std::chrono::steady_clock::now();
+
+		// Reset the results of a previous run
+		_upper_bound = std::numeric_limits<int>::max();
+		_optimal = false;
+		_best_activity_finish_times.clear();
+		_best = std::make_tuple(std::numeric_limits<int>::max(), 0, 0);
+		_best_makespan = std::numeric_limits<int>::max();
+		_nb_passes = 0;
+
+		const int nb_threads = (_solver_options.nb_workers > 0) ? _solver_options.nb_workers
+			: std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+		if (_solver_options.max_schedules > 0)
+			_max_passes = _solver_options.max_schedules;
+		_lower_bound = simple_lower_bound();
+		_output << "\nSeed " << _solver_options.seed << ", " << nb_threads << " threads, at most " << _max_passes << " passes"
+			<< (_solver_options.justify ? ", double justification of every schedule" : "");
+
+		// Main procedure: the passes are divided among the threads
+		std::exception_ptr error;
+		std::vector<std::thread> threads;
+		for (int w = 0; w < nb_threads; ++w)
+		{
+			const size_t nb_passes = _max_passes / nb_threads + (static_cast<size_t>(w) < _max_passes % nb_threads ? 1 : 0);
+			threads.emplace_back([this, w, nb_passes, &error]() {
+				try
+				{
+					sample(w, nb_passes);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (!error)
+						error = std::current_exception();
+				}
+				});
+		}
+		for (auto&& thread : threads)
+			thread.join();
+		if (error)
+			std::rethrow_exception(error);
+
+		// The best schedule
+		_upper_bound = _best_makespan;
+		_optimal = (_upper_bound == _lower_bound);
+		_nb_nodes = _nb_passes;
+
+		// Print statistics
+		std::chrono::duration<double, std::ratio<1, 1>> elapsed_time = std::chrono::steady_clock::now() - _start_time;
+		_output.set_on(!_silent);
+		if (_best_activity_finish_times.empty())
+		{
+			_output << "\n\n\nNo solution found within the time limit";
+		}
+		else
+		{
+			if (_optimal)
+				_output << "\n\n\nOptimal solution found with makespan " << _upper_bound;
+			else
+				_output << "\n\n\nBest solution found has makespan " << _upper_bound << " (lower bound " << _lower_bound << ")";
+			_output << "\nActivity finish times: "; for (int i = 0; i < _activities.size(); ++i) _output << "t(" << i + 1 << ") = " << _best_activity_finish_times[i] << "  ";
+		}
+		_output << "\n\nElapsed time (s): " << elapsed_time.count();
+		_output << "\nPasses: " << _nb_passes.load();
+		if (!_best_activity_finish_times.empty())
+			_output << " (best schedule by the " << (_best_parallel ? "parallel" : "serial") << " SGS)";
+	}
+}
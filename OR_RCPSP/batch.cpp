@@ -0,0 +1,293 @@
+#include "batch.h"
+#include "algorithms.h"
+#include "json.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+
+
+namespace RCPSP
+{
+	namespace
+	{
+		// true if name matches pattern, where '*' matches any sequence and '?' any single character
+		bool wildcard_match(const std::string& pattern, const std::string& name)
+		{
+			size_t p = 0, n = 0;
+			size_t star = std::string::npos, star_n = 0;
+			while (n < name.size())
+			{
+				if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+				{
+					++p;
+					++n;
+				}
+				else if (p < pattern.size() && pattern[p] == '*')
+				{
+					star = p++;
+					star_n = n;
+				}
+				else if (star != std::string::npos)
+				{
+					p = star + 1;
+					n = ++star_n;
+				}
+				else
+					return false;
+			}
+			while (p < pattern.size() && pattern[p] == '*')
+				++p;
+			return p == pattern.size();
+		}
+
+
+		// binary caches and their temporary files are not instances of their own
+		bool is_cache_file(const std::filesystem::path& path)
+		{
+			std::string ext = path.extension().string();
+			return ext == ".bin" || ext.rfind(".tmp", 0) == 0;
+		}
+
+
+		struct BatchRow
+		{
+			std::string instance;
+			int nb_activities = 0;
+			bool solved = false;
+			int makespan = 0;
+			int lower_bound = 0;
+			bool optimal = false;
+			bool valid = false;
+			double time = 0;
+			size_t nb_nodes = 0;
+			double root_bound = 0;			// LP relaxation bound of the IP, 0 for the other algorithms
+			std::string error;
+
+			double gap() const { return (makespan > 0) ? static_cast<double>(makespan - lower_bound) / makespan : 0.0; }
+		};
+
+
+		std::string csv_quote(const std::string& text)
+		{
+			if (text.find_first_of(",\"\n\r") == std::string::npos)
+				return text;
+
+			std::string quoted = "\"";
+			for (char c : text)
+			{
+				if (c == '"')
+					quoted += '"';
+				quoted += c;
+			}
+			return quoted + "\"";
+		}
+
+
+		const char* csv_header = "instance,activities,makespan,lower_bound,gap,optimal,valid,time,nodes,root_bound,error";
+
+		std::string format_row(const BatchRow& row, bool json)
+		{
+			std::ostringstream line;
+			if (json)
+			{
+				line << "{\"instance\":" << json_quote(row.instance)
+					<< ",\"activities\":" << row.nb_activities;
+				if (row.solved)
+					line << ",\"makespan\":" << row.makespan << ",\"lower_bound\":" << row.lower_bound << ",\"gap\":" << row.gap();
+				else
+					line << ",\"makespan\":null,\"lower_bound\":null,\"gap\":null";
+				line << ",\"optimal\":" << (row.optimal ? "true" : "false")
+					<< ",\"valid\":" << (row.valid ? "true" : "false")
+					<< ",\"time\":" << row.time
+					<< ",\"nodes\":" << row.nb_nodes;
+				if (row.root_bound > 0)
+					line << ",\"root_bound\":" << row.root_bound;
+				else
+					line << ",\"root_bound\":null";
+				line << ",\"error\":" << (row.error.empty() ? "null" : json_quote(row.error))
+					<< "}\n";
+			}
+			else
+			{
+				line << csv_quote(row.instance) << "," << row.nb_activities << ",";
+				if (row.solved)
+					line << row.makespan << "," << row.lower_bound << "," << row.gap();
+				else
+					line << ",,";
+				line << "," << (row.optimal ? 1 : 0)
+					<< "," << (row.valid ? 1 : 0)
+					<< "," << row.time
+					<< "," << row.nb_nodes
+					<< ",";
+				if (row.root_bound > 0)
+					line << row.root_bound;
+				line << "," << csv_quote(row.error)
+					<< "\n";
+			}
+			return line.str();
+		}
+	}
+
+
+	std::vector<std::string> collect_instances(const std::string& input)
+	{
+		namespace fs = std::filesystem;
+		std::vector<std::string> instances;
+
+		// A) directory: every regular file except hidden files and binary caches
+		if (fs::is_directory(input))
+		{
+			for (auto&& entry : fs::directory_iterator(input))
+			{
+				std::string name = entry.path().filename().string();
+				if (entry.is_regular_file() && name[0] != '.' && !is_cache_file(entry.path()))
+					instances.push_back(entry.path().string());
+			}
+			std::sort(instances.begin(), instances.end());
+			return instances;
+		}
+
+		// B) glob pattern: wildcards in the file name only
+		if (input.find_first_of("*?") != std::string::npos)
+		{
+			fs::path pattern(input);
+			fs::path directory = pattern.has_parent_path() ? pattern.parent_path() : fs::path(".");
+			std::string file_pattern = pattern.filename().string();
+			if (!fs::is_directory(directory))
+			{
+				throw std::invalid_argument("Couldn't find the directory " + directory.string());
+			}
+
+			for (auto&& entry : fs::directory_iterator(directory))
+			{
+				if (entry.is_regular_file() && wildcard_match(file_pattern, entry.path().filename().string()))
+					instances.push_back(entry.path().string());
+			}
+			std::sort(instances.begin(), instances.end());
+			return instances;
+		}
+
+		// C) manifest: one instance per line, relative to the directory of the manifest, '#' starts a comment
+		std::ifstream manifest(input);
+		if (!manifest.is_open())
+		{
+			throw std::invalid_argument("Couldn't open the file with name " + input);
+		}
+		fs::path base = fs::path(input).parent_path();
+		std::string line;
+		while (std::getline(manifest, line))
+		{
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#')
+				continue;
+			size_t last = line.find_last_not_of(" \t\r");
+			fs::path path(line.substr(first, last - first + 1));
+			instances.push_back(path.is_absolute() ? path.string() : (base / path).string());
+		}
+		return instances;
+	}
+
+
+	void run_batch(const BatchOptions& options)
+	{
+		const std::vector<std::string> instances = collect_instances(options.input);
+		if (instances.empty())
+		{
+			throw std::invalid_argument("No instances found for " + options.input);
+		}
+
+		const bool json = (options.format == "jsonl" || options.format == "json");
+		if (!json && options.format != "csv")
+		{
+			throw std::invalid_argument("No output format " + options.format + " exists");
+		}
+
+		std::ofstream file;
+		if (!options.output.empty())
+		{
+			file.open(options.output);
+			if (!file.is_open())
+			{
+				throw std::invalid_argument("Couldn't create the file with name " + options.output);
+			}
+		}
+
+		// one algorithm per worker, created up front so that an unknown algorithm is reported before any work starts
+		const size_t nb_workers = std::min<size_t>(std::max(options.nb_threads, 1), instances.size());
+		std::vector<std::unique_ptr<Algorithm>> algorithms;
+		for (size_t w = 0; w < nb_workers; ++w)
+		{
+			std::string name = options.algorithm;
+			algorithms.push_back(AlgorithmFactory::create(name));
+			algorithms.back()->set_silent(true);
+			algorithms.back()->set_solver_options(options.solver);
+			if (options.max_time > 0)
+				algorithms.back()->set_max_time(options.max_time);
+		}
+
+		std::ostream& out = options.output.empty() ? std::cout : file;
+		if (!json)
+			out << csv_header << "\n" << std::flush;
+
+		std::atomic<size_t> next_instance{ 0 };
+		std::mutex output_mutex;
+		auto start_batch = std::chrono::steady_clock::now();
+
+		auto worker = [&](Algorithm& algorithm) {
+			for (size_t index = next_instance++; index < instances.size(); index = next_instance++)
+			{
+				BatchRow row;
+				row.instance = instances[index];
+
+				auto start_time = std::chrono::steady_clock::now();
+				try
+				{
+					algorithm.read_data(row.instance, options.use_cache);
+					row.nb_activities = algorithm.nb_activities();
+					algorithm.run(false);
+					algorithm.justify();
+
+					row.solved = !algorithm.finish_times().empty();
+					row.makespan = algorithm.makespan();
+					row.lower_bound = algorithm.lower_bound();
+					row.optimal = algorithm.optimal();
+					row.nb_nodes = algorithm.nb_nodes();
+					row.root_bound = algorithm.root_bound();
+					row.valid = row.solved && algorithm.check_solution();
+				}
+				catch (const std::exception& e)
+				{
+					row.error = e.what();
+				}
+				std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+				row.time = elapsed_time.count();
+
+				std::string line = format_row(row, json);
+				std::lock_guard<std::mutex> lock(output_mutex);
+				out << line << std::flush;
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t w = 1; w < nb_workers; ++w)
+			threads.emplace_back(worker, std::ref(*algorithms[w]));
+		worker(*algorithms[0]);
+		for (auto&& thread : threads)
+			thread.join();
+
+		if (!options.output.empty())
+		{
+			std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_batch;
+			std::cout << "\nSolved " << instances.size() << " instances with " << nb_workers << " threads in "
+				<< elapsed_time.count() << " s; results written to " << options.output << "\n";
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#ifndef BATCH_RCPSP_H
+#define BATCH_RCPSP_H
+
+
+#include <string>
+#include <vector>
+#include "algorithms.h"
+
+
+
+namespace RCPSP // resource-constrained project scheduling problem
+{
+	// Solve many instances in one process with a bounded pool of worker threads
+	// Every worker creates its algorithm once and reuses it for all instances it solves
+	struct BatchOptions
+	{
+		std::string algorithm;
+		std::string input;				// directory, glob pattern (e.g. "j30/j30*.sm") or manifest file with one instance per line
+		int nb_threads = 1;
+		double max_time = 0;			// time limit per instance in seconds, 0 keeps the default of the algorithm
+		SolverOptions solver;			// options of the OR-Tools solvers
+		bool use_cache = false;			// read the instances through their binary cache
+		std::string format = "csv";		// "csv" or "jsonl"
+		std::string output;				// file for the result rows, empty for standard output
+	};
+
+	// List the instance files described by a directory, a glob pattern or a manifest file
+	std::vector<std::string> collect_instances(const std::string& input);
+
+	// Solve all instances and write one result row per instance as soon as it is solved
+	void run_batch(const BatchOptions& options);
+}
+
+#endif // BATCH_RCPSP_H
@@ -0,0 +1,156 @@
+#include "instance.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+
+
+namespace RCPSP
+{
+	void Instance::clear()
+	{
+		nb_activities = 0;
+		nb_resources = 0;
+		resource_availabilities.clear();
+		durations.clear();
+		requirements.clear();
+		successor_offsets.clear();
+		successors.clear();
+		predecessor_offsets.clear();
+		predecessors.clear();
+
+		rcpl.clear();
+		earliest_start.clear();
+		latest_start.clear();
+		closure_words = 0;
+		closure.clear();
+	}
+
+
+	void Instance::validate() const
+	{
+		const int n = nb_activities;
+		if (n < 2)
+			throw std::invalid_argument("The project should contain at least a dummy start and a dummy end activity");
+		if (nb_resources < 0)
+			throw std::invalid_argument("The number of resource types cannot be negative");
+		if (resource_availabilities.size() != static_cast<size_t>(nb_resources) || durations.size() != static_cast<size_t>(n)
+			|| requirements.size() != static_cast<size_t>(n) * nb_resources || successor_offsets.size() != static_cast<size_t>(n) + 1)
+		{
+			throw std::invalid_argument("The project data does not match the number of activities and resource types");
+		}
+
+		for (int k = 0; k < nb_resources; ++k)
+			if (resource_availabilities[k] < 0)
+				throw std::invalid_argument("Availability of resource type " + std::to_string(k + 1) + " cannot be negative");
+
+		// the sum of the durations is the horizon of the models, so it should fit in an int
+		long long total_duration = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			if (durations[i] < 0)
+				throw std::invalid_argument("Duration of activity " + std::to_string(i + 1) + " cannot be negative");
+			total_duration += durations[i];
+			for (int k = 0; k < nb_resources; ++k)
+				if (requirement(i, k) < 0)
+					throw std::invalid_argument("Resource requirement of activity " + std::to_string(i + 1) + " cannot be negative");
+		}
+		if (total_duration > std::numeric_limits<int>::max())
+			throw std::invalid_argument("The sum of the durations is too large");
+
+		if (successor_offsets[0] != 0 || static_cast<size_t>(successor_offsets[n]) != successors.size())
+			throw std::invalid_argument("Inconsistent successor arrays");
+		for (int i = 0; i < n; ++i)
+			if (successor_offsets[i] > successor_offsets[i + 1])
+				throw std::invalid_argument("Inconsistent successor arrays");
+		for (int i = 0; i < n; ++i)
+		{
+			for (const int* suc = successors_begin(i); suc != successors_end(i); ++suc)
+			{
+				if (*suc < 0 || *suc >= n)
+					throw std::invalid_argument("Successor " + std::to_string(*suc + 1) + " of activity " + std::to_string(i + 1)
+						+ " is not in the range 1.." + std::to_string(n));
+				if (*suc == i)
+					throw std::invalid_argument("Activity " + std::to_string(i + 1) + " cannot be its own successor");
+			}
+		}
+	}
+
+
+	void Instance::build_predecessors()
+	{
+		// count predecessors, then fill the arrays in order of the predecessor index
+		predecessor_offsets.assign(static_cast<size_t>(nb_activities) + 1, 0);
+		for (int suc : successors)
+			++predecessor_offsets[suc + 1];
+		for (int i = 0; i < nb_activities; ++i)
+			predecessor_offsets[i + 1] += predecessor_offsets[i];
+
+		predecessors.resize(successors.size());
+		std::vector<int> next(predecessor_offsets.begin(), predecessor_offsets.end() - 1);
+		for (int i = 0; i < nb_activities; ++i)
+			for (const int* suc = successors_begin(i); suc != successors_end(i); ++suc)
+				predecessors[next[*suc]++] = i;
+	}
+
+
+	void Instance::preprocess()
+	{
+		const int n = nb_activities;
+
+		// topological order (Kahn)
+		std::vector<int> order;
+		order.reserve(n);
+		{
+			std::vector<int> nb_unplaced_pred(n);
+			for (int i = 0; i < n; ++i)
+			{
+				nb_unplaced_pred[i] = predecessor_offsets[i + 1] - predecessor_offsets[i];
+				if (nb_unplaced_pred[i] == 0)
+					order.push_back(i);
+			}
+			for (size_t pos = 0; pos < order.size(); ++pos)
+			{
+				int i = order[pos];
+				for (const int* suc = successors_begin(i); suc != successors_end(i); ++suc)
+					if (--nb_unplaced_pred[*suc] == 0)
+						order.push_back(*suc);
+			}
+			if (static_cast<int>(order.size()) != n)
+				throw std::logic_error("The precedence relations contain a cycle");
+		}
+
+		// earliest start times (forward pass)
+		earliest_start.assign(n, 0);
+		for (int i : order)
+			for (const int* suc = successors_begin(i); suc != successors_end(i); ++suc)
+				earliest_start[*suc] = std::max(earliest_start[*suc], earliest_start[i] + durations[i]);
+
+		// remaining critical path lengths and transitive closure (backward pass)
+		rcpl.assign(n, 0);
+		closure_words = (n + 63) / 64;
+		closure.assign(static_cast<size_t>(n) * closure_words, 0);
+		for (auto it = order.rbegin(); it != order.rend(); ++it)
+		{
+			int i = *it;
+			uint64_t* row = closure.data() + static_cast<size_t>(i) * closure_words;
+
+			rcpl[i] = (i == n - 1) ? 0 : durations[i]; // dummy end activity
+			for (const int* suc = successors_begin(i); suc != successors_end(i); ++suc)
+			{
+				rcpl[i] = std::max(rcpl[i], durations[i] + rcpl[*suc]);
+
+				const uint64_t* suc_row = closure.data() + static_cast<size_t>(*suc) * closure_words;
+				for (int w = 0; w < closure_words; ++w)
+					row[w] |= suc_row[w];
+				row[*suc >> 6] |= uint64_t(1) << (*suc & 63);
+			}
+		}
+
+		// latest start times for a horizon equal to the critical path length
+		latest_start.resize(n);
+		for (int i = 0; i < n; ++i)
+			latest_start[i] = rcpl[0] - rcpl[i];
+	}
+}
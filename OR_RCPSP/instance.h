@@ -0,0 +1,131 @@
+#pragma once
+#ifndef INSTANCE_RCPSP_H
+#define INSTANCE_RCPSP_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+
+namespace RCPSP // resource-constrained project scheduling problem
+{
+	// Project data in flat, contiguous storage
+	// Activities are numbered from 0 and include the dummy start and end activities
+	struct Instance
+	{
+		int nb_activities = 0;
+		int nb_resources = 0;
+
+		std::vector<int> resource_availabilities;	// [k] == availability of resource type k
+		std::vector<int> durations;					// [i] == duration of activity i
+		std::vector<int> requirements;				// [i * nb_resources + k] == requirement of activity i for resource type k
+		std::vector<int> successor_offsets;			// successors of activity i are successors[successor_offsets[i] .. successor_offsets[i+1])
+		std::vector<int> successors;
+		std::vector<int> predecessor_offsets;		// predecessors of activity i, same layout as the successors
+		std::vector<int> predecessors;
+
+		// preprocessing results, empty until preprocess() is called
+		std::vector<int> rcpl;						// [i] == remaining critical path length from the start of activity i
+		std::vector<int> earliest_start;			// [i] == earliest start of activity i given the precedence relations
+		std::vector<int> latest_start;				// [i] == latest start of activity i for a horizon equal to the critical path length
+		int closure_words = 0;						// number of 64-bit words per row of the transitive closure
+		std::vector<uint64_t> closure;				// bit j of row i is set if activity i (transitively) precedes activity j
+
+		int requirement(int activity, int resource) const { return requirements[activity * nb_resources + resource]; }
+		int nb_successors(int activity) const { return successor_offsets[activity + 1] - successor_offsets[activity]; }
+		const int* successors_begin(int activity) const { return successors.data() + successor_offsets[activity]; }
+		const int* successors_end(int activity) const { return successors.data() + successor_offsets[activity + 1]; }
+		const int* predecessors_begin(int activity) const { return predecessors.data() + predecessor_offsets[activity]; }
+		const int* predecessors_end(int activity) const { return predecessors.data() + predecessor_offsets[activity + 1]; }
+
+		bool preprocessed() const { return !rcpl.empty(); }
+		bool precedes(int i, int j) const { return (closure[static_cast<size_t>(i) * closure_words + (j >> 6)] >> (j & 63)) & 1; }
+
+		void validate() const;		// check the sizes and values of the project data; throws std::invalid_argument
+		void build_predecessors();	// derive the predecessor arrays from the successor arrays
+		void preprocess();			// compute RCPL, ES/LS and the transitive closure; throws if the precedences contain a cycle
+		void clear();
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Error in an instance file, with the (1-based) line and column where it was detected
+	class ParseError : public std::runtime_error
+	{
+		size_t _line;
+		size_t _column;
+
+	public:
+		ParseError(const std::string& filename, size_t line, size_t column, const std::string& msg);
+
+		size_t line() const { return _line; }
+		size_t column() const { return _column; }
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Read-only memory mapping of a complete file
+	class MappedFile
+	{
+		const char* _data = nullptr;
+		size_t _size = 0;
+
+#ifdef _WIN32
+		void* _file = nullptr;
+		void* _mapping = nullptr;
+#else
+		int _file = -1;
+#endif
+
+	public:
+		explicit MappedFile(const std::string& filename);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* data() const { return _data; }
+		size_t size() const { return _size; }
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Supported formats
+	enum class InstanceFormat
+	{
+		Unknown,
+		Patterson,	// the .rcp layout of the files in datasets/
+		PSPLIB_SM,	// PSPLIB single-mode .sm files (J30, J60, J90, J120, ...)
+		Binary,		// binary instance cache written by write_binary
+	};
+
+	// Determine the format of [first, last) from its content
+	InstanceFormat detect_format(const char* first, const char* last);
+
+	// Parse [first, last) in one pass; these throw ParseError on malformed input
+	void parse_rcp(const char* first, const char* last, const std::string& filename, Instance& instance);
+	void parse_sm(const char* first, const char* last, const std::string& filename, Instance& instance);
+	void parse_instance(const char* first, const char* last, const std::string& filename, Instance& instance); // detects the format
+
+	// Memory-map a file and parse it in the format detected from its content
+	void read_instance(const std::string& filename, Instance& instance);
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Binary instance cache
+	// Layout: header, availabilities, durations, requirement matrix, successor and predecessor CSR arrays
+	// and, if the instance was preprocessed, RCPL, ES, LS and the transitive closure. Every section is 8-byte aligned.
+	// The header stores a hash of the text file the instance was read from, so that stale caches can be detected.
+	uint64_t content_hash(const char* first, const char* last);
+	void write_binary(const std::string& filename, const Instance& instance, uint64_t source_hash);
+	void load_binary(const char* first, const char* last, const std::string& filename, Instance& instance, uint64_t* source_hash = nullptr);
+
+	// Read a text instance through the cache filename + ".bin", which is (re)written when it is missing or stale
+	void read_instance_cached(const std::string& filename, Instance& instance);
+}
+
+#endif // INSTANCE_RCPSP_H
@@ -0,0 +1,754 @@
+#include "instance.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+namespace RCPSP
+{
+	ParseError::ParseError(const std::string& filename, size_t line, size_t column, const std::string& msg)
+		: std::runtime_error(filename + ":" + std::to_string(line) + ":" + std::to_string(column) + ": " + msg),
+		_line(line), _column(column)
+	{
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+		{
+			_file = nullptr;
+			throw std::invalid_argument("Couldn't open the file with name " + filename);
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size))
+		{
+			CloseHandle(_file);
+			throw std::invalid_argument("Couldn't determine the size of the file with name " + filename);
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+		if (_size == 0)
+			return; // empty files cannot be mapped
+
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mapping != nullptr)
+			_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (_data == nullptr)
+		{
+			if (_mapping != nullptr) CloseHandle(_mapping);
+			CloseHandle(_file);
+			throw std::invalid_argument("Couldn't map the file with name " + filename);
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_data != nullptr) UnmapViewOfFile(_data);
+		if (_mapping != nullptr) CloseHandle(_mapping);
+		if (_file != nullptr) CloseHandle(_file);
+	}
+#else
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		_file = open(filename.c_str(), O_RDONLY);
+		if (_file < 0)
+		{
+			throw std::invalid_argument("Couldn't open the file with name " + filename);
+		}
+
+		struct stat info;
+		if (fstat(_file, &info) != 0)
+		{
+			close(_file);
+			throw std::invalid_argument("Couldn't determine the size of the file with name " + filename);
+		}
+		_size = static_cast<size_t>(info.st_size);
+		if (_size == 0)
+			return; // empty files cannot be mapped
+
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+		if (data == MAP_FAILED)
+		{
+			close(_file);
+			throw std::invalid_argument("Couldn't map the file with name " + filename);
+		}
+		madvise(data, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const char*>(data);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_data != nullptr) munmap(const_cast<char*>(_data), _size);
+		if (_file >= 0) close(_file);
+	}
+#endif
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	namespace
+	{
+		// Reads whitespace-separated integers from a buffer
+		// The line and column are only computed when an error is reported, so they cost nothing while parsing
+		class Scanner
+		{
+			const char* _first;
+			const char* _cur;
+			const char* _last;
+			const char* _token;
+			const std::string& _filename;
+
+			static bool is_whitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+			void skip_whitespace()
+			{
+				const char* cur = _cur;
+				while (cur < _last && is_whitespace(*cur))
+					++cur;
+				_cur = cur;
+			}
+
+		public:
+			Scanner(const char* first, const char* last, const std::string& filename)
+				: _first(first), _cur(first), _last(last), _token(first), _filename(filename) {}
+
+			[[noreturn]] void error_at(const char* pos, const std::string& msg) const
+			{
+				size_t line = 1;
+				const char* line_start = _first;
+				for (const char* c = _first; c < pos; ++c)
+				{
+					if (*c == '\n')
+					{
+						++line;
+						line_start = c + 1;
+					}
+				}
+				throw ParseError(_filename, line, static_cast<size_t>(pos - line_start) + 1, msg);
+			}
+
+			// error at the start of the last token that was read
+			[[noreturn]] void error(const std::string& msg) const { error_at(_token, msg); }
+
+			// report why the token at _cur could not be read; kept out of the hot path of next_int
+			[[noreturn]] void invalid_token(const char* ptr, std::errc ec, const char* what) const
+			{
+				if (_cur == _last)
+					error_at(_cur, std::string("Unexpected end of file, expected ") + what);
+				if (ec == std::errc::invalid_argument)
+					error_at(_cur, std::string("Expected ") + what);
+				if (ec == std::errc::result_out_of_range)
+					error_at(_cur, std::string("Value out of range for ") + what);
+				error_at(ptr, std::string("Unexpected character in ") + what);
+			}
+
+			int next_int(const char* what)
+			{
+				skip_whitespace();
+				_token = _cur;
+
+				// fast path for the short unsigned numbers that make up nearly all of an instance file
+				const char* cur = _cur;
+				const char* digits_end = (_last - cur > 8) ? cur + 8 : _last;
+				unsigned int digits = 0;
+				while (cur < digits_end && static_cast<unsigned char>(*cur - '0') < 10)
+					digits = digits * 10 + static_cast<unsigned char>(*cur++ - '0');
+				if (cur != _cur && cur != digits_end && is_whitespace(*cur))
+				{
+					_cur = cur;
+					return static_cast<int>(digits);
+				}
+
+				// signs, long numbers, the last number of the file and errors
+				int value = 0;
+				auto [ptr, ec] = std::from_chars(_cur, _last, value);
+				if (ec != std::errc() || (ptr != _last && !is_whitespace(*ptr)))
+					invalid_token(ptr, ec, what);
+
+				_cur = ptr;
+				return value;
+			}
+
+			// move to just after the next occurrence of text
+			void skip_past(std::string_view text)
+			{
+				std::string_view rest(_cur, static_cast<size_t>(_last - _cur));
+				size_t pos = rest.find(text);
+				if (pos == std::string_view::npos)
+					error_at(_cur, "Expected \"" + std::string(text) + "\"");
+				_cur += pos + text.size();
+				_token = _cur;
+			}
+
+			// move to the start of the next line
+			void skip_line()
+			{
+				const char* eol = static_cast<const char*>(std::memchr(_cur, '\n', static_cast<size_t>(_last - _cur)));
+				_cur = (eol != nullptr) ? eol + 1 : _last;
+				_token = _cur;
+			}
+
+			// first character of the next token, or 0 at the end of the buffer
+			char peek()
+			{
+				skip_whitespace();
+				return (_cur < _last) ? *_cur : '\0';
+			}
+
+			bool at_end()
+			{
+				skip_whitespace();
+				_token = _cur;
+				return _cur == _last;
+			}
+		};
+
+
+		// Whether [first, last) can hold nb_activities times numbers_per_activity numbers of at least one digit and a
+		// separator; this bounds the arrays that are allocated from the counts in the header of a text file
+		bool fits_in_size(int nb_activities, long long numbers_per_activity, const char* first, const char* last)
+		{
+			return nb_activities * numbers_per_activity <= (last - first + 1) / 2;
+		}
+	}
+
+
+	namespace
+	{
+		// Binary instance cache
+		const char binary_magic[8] = { 'R', 'C', 'P', 'S', 'P', 'B', 'I', 'N' };
+		const uint32_t binary_version = 2;
+		const uint32_t binary_byte_order = 0x01020304;
+
+		struct BinaryHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order;		// binary_byte_order as written by the machine that created the file
+			uint64_t source_hash;		// content_hash of the text file the instance was read from
+			uint64_t data_hash;			// content_hash of the sections after the header, to detect corrupt files
+			int32_t nb_activities;
+			int32_t nb_resources;
+			int32_t nb_precedences;
+			int32_t closure_words;		// 0 if the file contains no preprocessing results
+		};
+		static_assert(sizeof(BinaryHeader) == 48, "BinaryHeader should not contain padding");
+
+		size_t aligned_size(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+
+
+		// Stored preprocessing results should be those of preprocess(): RCPL, ES and LS follow their recurrences, every
+		// successor is set in the closure row of its predecessor and no activity precedes itself. This takes linear time;
+		// the rest of the closure is covered by the data hash.
+		bool preprocessing_consistent(const Instance& instance)
+		{
+			const int n = instance.nb_activities;
+			for (int i = 0; i < n; ++i)
+			{
+				long long rcpl = (i == n - 1) ? 0 : instance.durations[i];
+				for (const int* suc = instance.successors_begin(i); suc != instance.successors_end(i); ++suc)
+				{
+					rcpl = std::max(rcpl, static_cast<long long>(instance.durations[i]) + instance.rcpl[*suc]);
+					if (!instance.precedes(i, *suc))
+						return false;
+				}
+				if (instance.rcpl[i] != rcpl || instance.precedes(i, i))
+					return false;
+
+				long long earliest_start = 0;
+				for (const int* pred = instance.predecessors_begin(i); pred != instance.predecessors_end(i); ++pred)
+					earliest_start = std::max(earliest_start, static_cast<long long>(instance.earliest_start[*pred]) + instance.durations[*pred]);
+				if (instance.earliest_start[i] != earliest_start
+					|| instance.latest_start[i] != static_cast<long long>(instance.rcpl[0]) - instance.rcpl[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+
+	void parse_rcp(const char* first, const char* last, const std::string& filename, Instance& instance)
+	{
+		// DATA SHOULD INCLUDE DUMMY START AND END ACTIVITIES
+		instance.clear();
+		Scanner in(first, last, filename);
+
+		const int nb_activities = in.next_int("number of activities");
+		if (nb_activities < 2)
+			in.error("Number of activities should be at least 2 (dummy start and end activity)");
+		const int nb_resources = in.next_int("number of resource types");
+		if (nb_resources < 0)
+			in.error("Number of resource types cannot be negative");
+		if (!fits_in_size(nb_activities, nb_resources + 2LL, first, last))
+			in.error("The numbers of activities and resource types do not fit in the size of the file");
+
+		instance.nb_activities = nb_activities;
+		instance.nb_resources = nb_resources;
+		instance.resource_availabilities.resize(nb_resources);
+		instance.durations.resize(nb_activities);
+		instance.requirements.resize(static_cast<size_t>(nb_activities) * nb_resources);
+		instance.successor_offsets.resize(static_cast<size_t>(nb_activities) + 1);
+		instance.successors.reserve(static_cast<size_t>(nb_activities) * 2);
+
+		for (int k = 0; k < nb_resources; ++k)
+		{
+			int av = in.next_int("resource availability");
+			if (av < 0)
+				in.error("Availability of resource type " + std::to_string(k + 1) + " cannot be negative");
+			instance.resource_availabilities[k] = av;
+		}
+
+		int* req = instance.requirements.data();
+		for (int i = 0; i < nb_activities; ++i)
+		{
+			int dur = in.next_int("activity duration");
+			if (dur < 0)
+				in.error("Duration of activity " + std::to_string(i + 1) + " cannot be negative");
+			instance.durations[i] = dur;
+
+			for (int k = 0; k < nb_resources; ++k)
+			{
+				int res = in.next_int("resource requirement");
+				if (res < 0)
+					in.error("Resource requirement of activity " + std::to_string(i + 1) + " cannot be negative");
+				*req++ = res;
+			}
+
+			instance.successor_offsets[i] = static_cast<int>(instance.successors.size());
+			int nbsucc = in.next_int("number of successors");
+			if (nbsucc < 0 || nbsucc >= nb_activities)
+				in.error("Invalid number of successors for activity " + std::to_string(i + 1));
+			for (int s = 0; s < nbsucc; ++s)
+			{
+				int suc = in.next_int("successor");
+				if (suc < 1 || suc > nb_activities)
+					in.error("Successor " + std::to_string(suc) + " of activity " + std::to_string(i + 1)
+						+ " is not in the range 1.." + std::to_string(nb_activities));
+				if (suc == i + 1)
+					in.error("Activity " + std::to_string(i + 1) + " cannot be its own successor");
+				instance.successors.push_back(suc - 1); // numbering starts at 1 instead of 0
+			}
+		}
+		instance.successor_offsets[nb_activities] = static_cast<int>(instance.successors.size());
+
+		if (!in.at_end())
+			in.error("Unexpected data after the last activity");
+
+		instance.build_predecessors();
+	}
+
+
+	void parse_sm(const char* first, const char* last, const std::string& filename, Instance& instance)
+	{
+		// jobs include the supersource and supersink, i.e. the dummy start and end activities
+		instance.clear();
+		Scanner in(first, last, filename);
+
+		// header
+		in.skip_past("jobs (incl. supersource/sink");
+		in.skip_past(":");
+		const int nb_activities = in.next_int("number of jobs");
+		if (nb_activities < 2)
+			in.error("Number of jobs should be at least 2 (supersource and supersink)");
+
+		in.skip_past("- renewable");
+		in.skip_past(":");
+		const int nb_resources = in.next_int("number of renewable resources");
+		if (nb_resources < 0)
+			in.error("Number of renewable resources cannot be negative");
+		if (!fits_in_size(nb_activities, nb_resources + 6LL, first, last))
+			in.error("The numbers of jobs and renewable resources do not fit in the size of the file");
+
+		in.skip_past("- nonrenewable");
+		in.skip_past(":");
+		if (in.next_int("number of nonrenewable resources") != 0)
+			in.error("Nonrenewable resources are not supported");
+
+		in.skip_past("- doubly constrained");
+		in.skip_past(":");
+		if (in.next_int("number of doubly constrained resources") != 0)
+			in.error("Doubly constrained resources are not supported");
+
+		instance.nb_activities = nb_activities;
+		instance.nb_resources = nb_resources;
+		instance.resource_availabilities.resize(nb_resources);
+		instance.durations.resize(nb_activities);
+		instance.requirements.resize(static_cast<size_t>(nb_activities) * nb_resources);
+		instance.successor_offsets.resize(static_cast<size_t>(nb_activities) + 1);
+		instance.successors.reserve(static_cast<size_t>(nb_activities) * 3);
+
+		// precedence relations: jobnr. #modes #successors successors
+		in.skip_past("PRECEDENCE RELATIONS:");
+		in.skip_line();
+		in.skip_line(); // column headers
+		for (int i = 0; i < nb_activities; ++i)
+		{
+			if (in.next_int("job number") != i + 1)
+				in.error("Expected job number " + std::to_string(i + 1));
+			if (in.next_int("number of modes") != 1)
+				in.error("Job " + std::to_string(i + 1) + " has more than one mode; only single-mode instances are supported");
+
+			instance.successor_offsets[i] = static_cast<int>(instance.successors.size());
+			int nbsucc = in.next_int("number of successors");
+			if (nbsucc < 0 || nbsucc >= nb_activities)
+				in.error("Invalid number of successors for job " + std::to_string(i + 1));
+			for (int s = 0; s < nbsucc; ++s)
+			{
+				int suc = in.next_int("successor");
+				if (suc < 1 || suc > nb_activities)
+					in.error("Successor " + std::to_string(suc) + " of job " + std::to_string(i + 1)
+						+ " is not in the range 1.." + std::to_string(nb_activities));
+				if (suc == i + 1)
+					in.error("Job " + std::to_string(i + 1) + " cannot be its own successor");
+				instance.successors.push_back(suc - 1); // numbering starts at 1 instead of 0
+			}
+		}
+		instance.successor_offsets[nb_activities] = static_cast<int>(instance.successors.size());
+
+		// requests/durations: jobnr. mode duration R 1 ... R K
+		in.skip_past("REQUESTS/DURATIONS:");
+		in.skip_line();
+		in.skip_line(); // column headers
+		if (in.peek() == '-')
+			in.skip_line(); // separator
+		int* req = instance.requirements.data();
+		for (int i = 0; i < nb_activities; ++i)
+		{
+			if (in.next_int("job number") != i + 1)
+				in.error("Expected job number " + std::to_string(i + 1));
+			if (in.next_int("mode") != 1)
+				in.error("Job " + std::to_string(i + 1) + " should have mode 1");
+
+			int dur = in.next_int("duration");
+			if (dur < 0)
+				in.error("Duration of job " + std::to_string(i + 1) + " cannot be negative");
+			instance.durations[i] = dur;
+
+			for (int k = 0; k < nb_resources; ++k)
+			{
+				int res = in.next_int("resource request");
+				if (res < 0)
+					in.error("Resource request of job " + std::to_string(i + 1) + " cannot be negative");
+				*req++ = res;
+			}
+		}
+
+		// resource availabilities
+		in.skip_past("RESOURCEAVAILABILITIES:");
+		in.skip_line();
+		in.skip_line(); // column headers
+		for (int k = 0; k < nb_resources; ++k)
+		{
+			int av = in.next_int("resource availability");
+			if (av < 0)
+				in.error("Availability of resource type " + std::to_string(k + 1) + " cannot be negative");
+			instance.resource_availabilities[k] = av;
+		}
+
+		instance.build_predecessors();
+	}
+
+
+	InstanceFormat detect_format(const char* first, const char* last)
+	{
+		if (static_cast<size_t>(last - first) >= sizeof(binary_magic) && std::memcmp(first, binary_magic, sizeof(binary_magic)) == 0)
+			return InstanceFormat::Binary;
+
+		const char* c = first;
+		while (c < last && (*c == ' ' || *c == '\n' || *c == '\r' || *c == '\t'))
+			++c;
+
+		if (c < last && (*c == '-' || (*c >= '0' && *c <= '9')))
+			return InstanceFormat::Patterson;
+
+		std::string_view text(first, static_cast<size_t>(last - first));
+		if (text.find("PRECEDENCE RELATIONS:") != std::string_view::npos)
+			return InstanceFormat::PSPLIB_SM;
+
+		return InstanceFormat::Unknown;
+	}
+
+
+	void parse_instance(const char* first, const char* last, const std::string& filename, Instance& instance)
+	{
+		switch (detect_format(first, last))
+		{
+		case InstanceFormat::Patterson:
+			parse_rcp(first, last, filename, instance);
+			break;
+		case InstanceFormat::PSPLIB_SM:
+			parse_sm(first, last, filename, instance);
+			break;
+		case InstanceFormat::Binary:
+			load_binary(first, last, filename, instance);
+			break;
+		default:
+			throw ParseError(filename, 1, 1, "Unknown instance format (expected Patterson/.rcp or PSPLIB .sm)");
+		}
+	}
+
+
+	void read_instance(const std::string& filename, Instance& instance)
+	{
+		MappedFile file(filename);
+		parse_instance(file.data(), file.data() + file.size(), filename, instance);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	uint64_t content_hash(const char* first, const char* last)
+	{
+		// FNV-1a over 64-bit words in four independent lanes, so that the multiplications overlap, followed by the
+		// remaining words and bytes
+		const uint64_t prime = 0x100000001b3ULL;
+		uint64_t lanes[4] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL };
+
+		const char* c = first;
+		for (; last - c >= 32; c += 32)
+		{
+			for (int l = 0; l < 4; ++l)
+			{
+				uint64_t word;
+				std::memcpy(&word, c + 8 * l, sizeof(word));
+				lanes[l] = (lanes[l] ^ word) * prime;
+				lanes[l] ^= lanes[l] >> 29;
+			}
+		}
+		uint64_t hash = lanes[0];
+		for (int l = 1; l < 4; ++l)
+			hash = (hash ^ lanes[l]) * prime;
+		for (; last - c >= 8; c += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, c, sizeof(word));
+			hash = (hash ^ word) * prime;
+			hash ^= hash >> 29;
+		}
+		for (; c < last; ++c)
+			hash = (hash ^ static_cast<unsigned char>(*c)) * prime;
+
+		return hash;
+	}
+
+
+	void write_binary(const std::string& filename, const Instance& instance, uint64_t source_hash)
+	{
+		BinaryHeader header;
+		std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+		header.version = binary_version;
+		header.byte_order = binary_byte_order;
+		header.source_hash = source_hash;
+		header.nb_activities = instance.nb_activities;
+		header.nb_resources = instance.nb_resources;
+		header.nb_precedences = static_cast<int32_t>(instance.successors.size());
+		header.closure_words = instance.preprocessed() ? instance.closure_words : 0;
+
+		// the sections are assembled in memory first, because the header holds their hash
+		std::string data;
+		auto write_section = [&data](const void* section, size_t bytes) {
+			data.append(static_cast<const char*>(section), bytes);
+			data.append(aligned_size(bytes) - bytes, '\0');
+		};
+		auto write_array = [&write_section](const auto& vec) {
+			write_section(vec.data(), vec.size() * sizeof(vec[0]));
+		};
+
+		write_section(&header, sizeof(header));
+		write_array(instance.resource_availabilities);
+		write_array(instance.durations);
+		write_array(instance.requirements);
+		write_array(instance.successor_offsets);
+		write_array(instance.successors);
+		write_array(instance.predecessor_offsets);
+		write_array(instance.predecessors);
+		if (header.closure_words > 0)
+		{
+			write_array(instance.rcpl);
+			write_array(instance.earliest_start);
+			write_array(instance.latest_start);
+			write_array(instance.closure);
+		}
+		header.data_hash = content_hash(data.data() + aligned_size(sizeof(header)), data.data() + data.size());
+		std::memcpy(data.data(), &header, sizeof(header));
+
+		// write to a temporary file first, so that concurrent readers never see a partially written cache
+		const std::string tmp_filename = filename + ".tmp" + std::to_string(std::random_device()());
+		{
+			std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				throw std::invalid_argument("Couldn't create the file with name " + tmp_filename);
+			}
+
+			file.write(data.data(), data.size());
+			if (!file.good())
+			{
+				file.close();
+				std::remove(tmp_filename.c_str());
+				throw std::runtime_error("Couldn't write the binary instance file " + filename);
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tmp_filename, filename, ec);
+		if (ec)
+		{
+			std::remove(tmp_filename.c_str());
+			throw std::runtime_error("Couldn't write the binary instance file " + filename + ": " + ec.message());
+		}
+	}
+
+
+	void load_binary(const char* first, const char* last, const std::string& filename, Instance& instance, uint64_t* source_hash)
+	{
+		auto invalid = [&filename](const std::string& reason) {
+			throw std::invalid_argument("Binary instance file " + filename + " is invalid: " + reason);
+		};
+
+		// header
+		BinaryHeader header;
+		if (static_cast<size_t>(last - first) < sizeof(header))
+			invalid("file too small");
+		std::memcpy(&header, first, sizeof(header));
+		if (std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0)
+			invalid("wrong file signature");
+		if (header.version != binary_version)
+			invalid("format version " + std::to_string(header.version) + " is not supported");
+		if (header.byte_order != binary_byte_order)
+			invalid("written on a machine with a different byte order");
+
+		const int n = header.nb_activities;
+		const int m = header.nb_precedences;
+		if (n < 2 || header.nb_resources < 0 || m < 0)
+			invalid("invalid number of activities, resources or precedences");
+		if (header.closure_words != 0 && header.closure_words != (n + 63) / 64)
+			invalid("invalid size of the transitive closure");
+		if (content_hash(first + aligned_size(sizeof(header)), last) != header.data_hash)
+			invalid("the data does not match its hash");
+
+		instance.clear();
+		instance.nb_activities = n;
+		instance.nb_resources = header.nb_resources;
+
+		// sections: the file is only read through memcpy, so its alignment does not matter
+		const char* pos = first + aligned_size(sizeof(header));
+		auto read_array = [&](auto& vec, size_t count) {
+			if (count > static_cast<size_t>(last - pos) / sizeof(vec[0]))
+				invalid("file is truncated");
+			const size_t bytes = count * sizeof(vec[0]);
+			if (aligned_size(bytes) > static_cast<size_t>(last - pos))
+				invalid("file is truncated");
+			vec.resize(count);
+			std::memcpy(vec.data(), pos, bytes);
+			pos += aligned_size(bytes);
+		};
+
+		read_array(instance.resource_availabilities, header.nb_resources);
+		read_array(instance.durations, n);
+		read_array(instance.requirements, static_cast<size_t>(n) * header.nb_resources);
+		read_array(instance.successor_offsets, static_cast<size_t>(n) + 1);
+		read_array(instance.successors, m);
+		read_array(instance.predecessor_offsets, static_cast<size_t>(n) + 1);
+		read_array(instance.predecessors, m);
+		if (header.closure_words > 0)
+		{
+			instance.closure_words = header.closure_words;
+			read_array(instance.rcpl, n);
+			read_array(instance.earliest_start, n);
+			read_array(instance.latest_start, n);
+			read_array(instance.closure, static_cast<size_t>(n) * header.closure_words);
+		}
+
+		// the data gets the checks of a parsed instance, the predecessor arrays are derived from the successors again and
+		// the preprocessing results are checked, so that a file from another writer cannot break the algorithms
+		try
+		{
+			instance.validate();
+		}
+		catch (const std::invalid_argument& e)
+		{
+			invalid(e.what());
+		}
+		instance.build_predecessors();
+		if (header.closure_words > 0 && !preprocessing_consistent(instance))
+			invalid("the preprocessing results do not match the precedence relations");
+
+		if (source_hash != nullptr)
+			*source_hash = header.source_hash;
+	}
+
+
+	void read_instance_cached(const std::string& filename, Instance& instance)
+	{
+		MappedFile source(filename);
+		const char* first = source.data();
+		const char* last = first + source.size();
+
+		if (detect_format(first, last) == InstanceFormat::Binary)
+		{
+			load_binary(first, last, filename, instance);
+			return;
+		}
+
+		// use the cache if it was created from the same content
+		const uint64_t hash = content_hash(first, last);
+		const std::string cache_filename = filename + ".bin";
+		std::error_code ec;
+		if (std::filesystem::exists(cache_filename, ec))
+		{
+			try
+			{
+				MappedFile cache(cache_filename);
+				uint64_t cached_hash = 0;
+				load_binary(cache.data(), cache.data() + cache.size(), cache_filename, instance, &cached_hash);
+				if (cached_hash == hash && instance.preprocessed())
+					return;
+			}
+			catch (const std::invalid_argument&)
+			{
+				// unreadable or written by another version: rebuild the cache
+			}
+		}
+
+		// stale or missing cache; the parsed instance is still used when the cache cannot be written (e.g. read-only directory)
+		parse_instance(first, last, filename, instance);
+		instance.preprocess();
+		try
+		{
+			write_binary(cache_filename, instance, hash);
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
+}
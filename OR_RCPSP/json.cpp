@@ -0,0 +1,269 @@
+#include "json.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+
+
+namespace RCPSP
+{
+	const JsonValue* JsonValue::find(const std::string& key) const
+	{
+		if (type != Type::Object)
+			return nullptr;
+		for (auto&& member : object)
+			if (member.first == key)
+				return &member.second;
+		return nullptr;
+	}
+
+
+	int JsonValue::as_int(const char* what) const
+	{
+		if (type != Type::Number || number != std::floor(number) || std::fabs(number) > 2147483647.0)
+			throw std::invalid_argument(std::string("Expected an integer for ") + what);
+		return static_cast<int>(number);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	namespace
+	{
+		// Recursive descent parser
+		class JsonParser
+		{
+			const char* _first;
+			const char* _cur;
+			const char* _last;
+			int _depth = 0;
+
+			[[noreturn]] void error(const std::string& msg) const
+			{
+				throw std::invalid_argument("Invalid JSON at offset " + std::to_string(_cur - _first) + ": " + msg);
+			}
+
+			void skip_whitespace()
+			{
+				while (_cur < _last && (*_cur == ' ' || *_cur == '\n' || *_cur == '\r' || *_cur == '\t'))
+					++_cur;
+			}
+
+			void expect(char c)
+			{
+				skip_whitespace();
+				if (_cur == _last || *_cur != c)
+					error(std::string("expected '") + c + "'");
+				++_cur;
+			}
+
+			bool consume(const char* word)
+			{
+				const char* c = _cur;
+				for (; *word != '\0'; ++word, ++c)
+					if (c == _last || *c != *word)
+						return false;
+				_cur = c;
+				return true;
+			}
+
+			static void append_utf8(std::string& out, unsigned int code)
+			{
+				if (code < 0x80)
+					out += static_cast<char>(code);
+				else if (code < 0x800)
+				{
+					out += static_cast<char>(0xC0 | (code >> 6));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					out += static_cast<char>(0xE0 | (code >> 12));
+					out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (code & 0x3F));
+				}
+			}
+
+			std::string parse_string()
+			{
+				expect('"');
+				std::string result;
+				while (true)
+				{
+					if (_cur == _last)
+						error("unterminated string");
+					char c = *_cur++;
+					if (c == '"')
+						return result;
+					if (c != '\\')
+					{
+						result += c;
+						continue;
+					}
+
+					if (_cur == _last)
+						error("unterminated string");
+					switch (*_cur++)
+					{
+					case '"': result += '"'; break;
+					case '\\': result += '\\'; break;
+					case '/': result += '/'; break;
+					case 'b': result += '\b'; break;
+					case 'f': result += '\f'; break;
+					case 'n': result += '\n'; break;
+					case 'r': result += '\r'; break;
+					case 't': result += '\t'; break;
+					case 'u':
+					{
+						if (_last - _cur < 4)
+							error("invalid unicode escape");
+						char hex[5] = { _cur[0], _cur[1], _cur[2], _cur[3], '\0' };
+						char* end = nullptr;
+						unsigned long code = std::strtoul(hex, &end, 16);
+						if (end != hex + 4)
+							error("invalid unicode escape");
+						append_utf8(result, static_cast<unsigned int>(code));
+						_cur += 4;
+						break;
+					}
+					default:
+						error("invalid escape sequence");
+					}
+				}
+			}
+
+			JsonValue parse_value()
+			{
+				if (++_depth > 64)
+					error("nesting too deep");
+
+				skip_whitespace();
+				if (_cur == _last)
+					error("unexpected end of input");
+
+				JsonValue value;
+				char c = *_cur;
+				if (c == '{')
+				{
+					value.type = JsonValue::Type::Object;
+					++_cur;
+					skip_whitespace();
+					if (_cur < _last && *_cur == '}')
+						++_cur;
+					else
+					{
+						do
+						{
+							skip_whitespace();
+							std::string key = parse_string();
+							expect(':');
+							value.object.emplace_back(std::move(key), parse_value());
+							skip_whitespace();
+						} while (_cur < _last && *_cur == ',' && ++_cur);
+						expect('}');
+					}
+				}
+				else if (c == '[')
+				{
+					value.type = JsonValue::Type::Array;
+					++_cur;
+					skip_whitespace();
+					if (_cur < _last && *_cur == ']')
+						++_cur;
+					else
+					{
+						do
+						{
+							value.array.push_back(parse_value());
+							skip_whitespace();
+						} while (_cur < _last && *_cur == ',' && ++_cur);
+						expect(']');
+					}
+				}
+				else if (c == '"')
+				{
+					value.type = JsonValue::Type::String;
+					value.string = parse_string();
+				}
+				else if (consume("true"))
+				{
+					value.type = JsonValue::Type::Bool;
+					value.boolean = true;
+				}
+				else if (consume("false"))
+				{
+					value.type = JsonValue::Type::Bool;
+				}
+				else if (consume("null"))
+				{
+				}
+				else
+				{
+					// strtod needs a terminated buffer
+					const char* end = _cur;
+					while (end < _last && (std::isdigit(static_cast<unsigned char>(*end)) || *end == '-' || *end == '+' || *end == '.' || *end == 'e' || *end == 'E'))
+						++end;
+					std::string number(_cur, end);
+					char* parsed = nullptr;
+					value.type = JsonValue::Type::Number;
+					value.number = std::strtod(number.c_str(), &parsed);
+					if (number.empty() || parsed != number.c_str() + number.size())
+						error("invalid value");
+					_cur = end;
+				}
+
+				--_depth;
+				return value;
+			}
+
+		public:
+			JsonParser(const char* first, const char* last) : _first(first), _cur(first), _last(last) {}
+
+			JsonValue parse()
+			{
+				JsonValue value = parse_value();
+				skip_whitespace();
+				if (_cur != _last)
+					error("unexpected data after the document");
+				return value;
+			}
+		};
+	}
+
+
+	JsonValue parse_json(const char* first, const char* last)
+	{
+		JsonParser parser(first, last);
+		return parser.parse();
+	}
+
+
+	std::string json_quote(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for (char c : text)
+		{
+			switch (c)
+			{
+			case '"': quoted += "\\\""; break;
+			case '\\': quoted += "\\\\"; break;
+			case '\n': quoted += "\\n"; break;
+			case '\r': quoted += "\\r"; break;
+			case '\t': quoted += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+					quoted += buffer;
+				}
+				else
+					quoted += c;
+			}
+		}
+		return quoted + "\"";
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef JSON_RCPSP_H
+#define JSON_RCPSP_H
+
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+namespace RCPSP // resource-constrained project scheduling problem
+{
+	// Minimal JSON support for the batch results and the solve server
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0;
+		std::string string;
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+
+		const JsonValue* find(const std::string& key) const; // nullptr if not an object or key not present
+		int as_int(const char* what) const; // throws std::invalid_argument if not an integer
+	};
+
+	// Parse a complete JSON document; throws std::invalid_argument on malformed input
+	JsonValue parse_json(const char* first, const char* last);
+
+	// Quoted and escaped JSON string
+	std::string json_quote(const std::string& text);
+}
+
+#endif // JSON_RCPSP_H
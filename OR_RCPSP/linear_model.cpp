@@ -0,0 +1,479 @@
+#include "linear_model.h"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+
+
+namespace RCPSP
+{
+	void ModelName::append_to(std::string& out) const
+	{
+		out += prefix;
+		char number[16];
+		for (int part : { first, second, third })
+		{
+			if (part < 0)
+				break;
+			out += '_';
+			auto result = std::to_chars(number, number + sizeof(number), part);
+			out.append(number, result.ptr);
+		}
+	}
+
+
+	std::string ModelName::str() const
+	{
+		std::string out;
+		append_to(out);
+		return out;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	int LinearModel::Rows::add(double row_lb, double row_ub, ModelName name)
+	{
+		lb.push_back(row_lb);
+		ub.push_back(row_ub);
+		names.push_back(name);
+		offsets.push_back(columns.size());
+		return static_cast<int>(lb.size()) - 1;
+	}
+
+
+	void LinearModel::Rows::add_terms(const int* first_column, const double* first_value, size_t nb_terms)
+	{
+		columns.insert(columns.end(), first_column, first_column + nb_terms);
+		values.insert(values.end(), first_value, first_value + nb_terms);
+		offsets.back() += nb_terms;
+	}
+
+
+	void LinearModel::Rows::reserve(size_t nb_rows, size_t nb_nonzeros)
+	{
+		lb.reserve(nb_rows);
+		ub.reserve(nb_rows);
+		names.reserve(nb_rows);
+		offsets.reserve(nb_rows + 1);
+		columns.reserve(nb_nonzeros);
+		values.reserve(nb_nonzeros);
+	}
+
+
+	void LinearModel::Rows::clear()
+	{
+		lb.clear();
+		ub.clear();
+		names.clear();
+		offsets.assign(1, 0);
+		columns.clear();
+		values.clear();
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	int LinearModel::add_variable(double lb, double ub, bool integer, ModelName name)
+	{
+		_lb.push_back(lb);
+		_ub.push_back(ub);
+		_integer.push_back(integer ? 1 : 0);
+		_variable_names.push_back(name);
+		_objective.push_back(0.0);
+		return static_cast<int>(_lb.size()) - 1;
+	}
+
+
+	void LinearModel::set_bounds(int variable, double lb, double ub)
+	{
+		_lb[variable] = lb;
+		_ub[variable] = ub;
+	}
+
+
+	void LinearModel::set_objective(int variable, double coefficient)
+	{
+		_objective[variable] = coefficient;
+	}
+
+
+	void LinearModel::add_rows(const Rows& rows)
+	{
+		const size_t shift = _rows.columns.size();
+		_rows.lb.insert(_rows.lb.end(), rows.lb.begin(), rows.lb.end());
+		_rows.ub.insert(_rows.ub.end(), rows.ub.begin(), rows.ub.end());
+		_rows.names.insert(_rows.names.end(), rows.names.begin(), rows.names.end());
+		for (size_t r = 1; r < rows.offsets.size(); ++r)
+			_rows.offsets.push_back(shift + rows.offsets[r]);
+		_rows.columns.insert(_rows.columns.end(), rows.columns.begin(), rows.columns.end());
+		_rows.values.insert(_rows.values.end(), rows.values.begin(), rows.values.end());
+	}
+
+
+	void LinearModel::reserve(size_t nb_variables, size_t nb_rows, size_t nb_nonzeros)
+	{
+		_lb.reserve(nb_variables);
+		_ub.reserve(nb_variables);
+		_integer.reserve(nb_variables);
+		_variable_names.reserve(nb_variables);
+		_objective.reserve(nb_variables);
+		_rows.reserve(nb_rows, nb_nonzeros);
+	}
+
+
+	void LinearModel::clear()
+	{
+		_lb.clear();
+		_ub.clear();
+		_integer.clear();
+		_variable_names.clear();
+		_objective.clear();
+		_rows.clear();
+	}
+
+
+	std::vector<operations_research::MPVariable*> LinearModel::load(operations_research::MPSolver& solver, bool relaxation) const
+	{
+		const std::string anonymous;
+		std::vector<operations_research::MPVariable*> variables;
+		variables.reserve(_lb.size());
+		for (size_t j = 0; j < _lb.size(); ++j)
+			variables.push_back(solver.MakeVar(_lb[j], _ub[j], _integer[j] != 0 && !relaxation, anonymous));
+
+		operations_research::MPObjective* objective = solver.MutableObjective();
+		objective->SetMinimization();
+		for (size_t j = 0; j < _objective.size(); ++j)
+			if (_objective[j] != 0.0)
+				objective->SetCoefficient(variables[j], _objective[j]);
+
+		for (size_t r = 0; r < _rows.size(); ++r)
+		{
+			operations_research::MPConstraint* constraint = solver.MakeRowConstraint(_rows.lb[r], _rows.ub[r], anonymous);
+			for (size_t e = _rows.offsets[r]; e < _rows.offsets[r + 1]; ++e)
+				constraint->SetCoefficient(variables[_rows.columns[e]], _rows.values[e]);
+		}
+		return variables;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	namespace
+	{
+		// Buffered text output with shortest round-trip formatting of numbers
+		class ModelWriter
+		{
+			std::ostream& _out;
+			std::string _buffer;
+
+		public:
+			explicit ModelWriter(std::ostream& out) : _out(out) { _buffer.reserve(1 << 20); }
+			~ModelWriter() { flush(); }
+
+			void flush()
+			{
+				_out.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+				_buffer.clear();
+			}
+
+			ModelWriter& operator<<(const std::string& text)
+			{
+				_buffer += text;
+				if (_buffer.size() >= (1 << 20))
+					flush();
+				return *this;
+			}
+
+			ModelWriter& operator<<(const char* text)
+			{
+				_buffer += text;
+				if (_buffer.size() >= (1 << 20))
+					flush();
+				return *this;
+			}
+
+			ModelWriter& operator<<(double value)
+			{
+				if (std::isinf(value))
+				{
+					_buffer += (value > 0) ? "+inf" : "-inf";
+					return *this;
+				}
+				char number[32];
+				auto result = std::to_chars(number, number + sizeof(number), value);
+				_buffer.append(number, result.ptr);
+				return *this;
+			}
+		};
+
+
+		bool is_binary(double lb, double ub, char integer)
+		{
+			return integer && lb == 0.0 && ub == 1.0;
+		}
+
+
+		std::vector<std::string> generate_names(const std::vector<ModelName>& names)
+		{
+			std::vector<std::string> result(names.size());
+			for (size_t i = 0; i < names.size(); ++i)
+				names[i].append_to(result[i]);
+			return result;
+		}
+	}
+
+
+	void LinearModel::write_lp(std::ostream& out) const
+	{
+		ModelWriter writer(out);
+		const double infinity = std::numeric_limits<double>::infinity();
+		const std::vector<std::string> variable_names = generate_names(_variable_names);
+		const std::vector<std::string> row_names = generate_names(_rows.names);
+
+		// a sum of terms, broken into lines of at most 8 terms
+		auto write_terms = [&](const int* columns, const double* values, size_t nb_terms) {
+			if (nb_terms == 0)
+			{
+				writer << "0 " << variable_names[0];
+				return;
+			}
+			for (size_t e = 0; e < nb_terms; ++e)
+			{
+				if (e > 0 && e % 8 == 0)
+					writer << "\n   ";
+				double value = values[e];
+				if (e > 0 || value < 0)
+					writer << ((value < 0) ? (e > 0 ? " - " : "- ") : " + ");
+				writer << std::fabs(value) << " " << variable_names[columns[e]];
+			}
+		};
+
+		writer << "\\ RCPSP model with " << std::to_string(nb_variables()) << " variables and " << std::to_string(nb_rows()) << " constraints\n";
+
+		// objective
+		{
+			std::vector<int> columns;
+			std::vector<double> values;
+			for (size_t j = 0; j < _objective.size(); ++j)
+			{
+				if (_objective[j] != 0.0)
+				{
+					columns.push_back(static_cast<int>(j));
+					values.push_back(_objective[j]);
+				}
+			}
+			writer << "Minimize\n obj: ";
+			if (!columns.empty())
+				write_terms(columns.data(), values.data(), columns.size());
+			writer << "\n";
+		}
+
+		// constraints, ranged rows are split in a lower and an upper part
+		writer << "Subject To\n";
+		for (size_t r = 0; r < _rows.size(); ++r)
+		{
+			const int* columns = _rows.columns.data() + _rows.offsets[r];
+			const double* values = _rows.values.data() + _rows.offsets[r];
+			const size_t nb_terms = _rows.offsets[r + 1] - _rows.offsets[r];
+			const double lb = _rows.lb[r], ub = _rows.ub[r];
+
+			if (lb == ub)
+			{
+				writer << " " << row_names[r] << ": ";
+				write_terms(columns, values, nb_terms);
+				writer << " = " << lb << "\n";
+			}
+			else
+			{
+				if (lb > -infinity || ub == infinity)
+				{
+					writer << " " << row_names[r] << ((ub < infinity) ? "_lb: " : ": ");
+					write_terms(columns, values, nb_terms);
+					writer << " >= " << ((lb > -infinity) ? lb : -1e30) << "\n";
+				}
+				if (ub < infinity)
+				{
+					writer << " " << row_names[r] << ((lb > -infinity) ? "_ub: " : ": ");
+					write_terms(columns, values, nb_terms);
+					writer << " <= " << ub << "\n";
+				}
+			}
+		}
+
+		// bounds, the default is [0, +inf)
+		writer << "Bounds\n";
+		for (size_t j = 0; j < _lb.size(); ++j)
+		{
+			if (_lb[j] == _ub[j])
+				writer << " " << variable_names[j] << " = " << _lb[j] << "\n";
+			else if (_lb[j] == -infinity && _ub[j] == infinity)
+				writer << " " << variable_names[j] << " free\n";
+			else if (!is_binary(_lb[j], _ub[j], _integer[j]) && (_lb[j] != 0.0 || _ub[j] != infinity))
+				writer << " " << _lb[j] << " <= " << variable_names[j] << " <= " << _ub[j] << "\n";
+		}
+
+		// integer variables
+		bool header = false;
+		for (size_t j = 0; j < _lb.size(); ++j)
+		{
+			if (_lb[j] != _ub[j] && is_binary(_lb[j], _ub[j], _integer[j]))
+			{
+				if (!header)
+					writer << "Binaries\n";
+				header = true;
+				writer << " " << variable_names[j] << "\n";
+			}
+		}
+		header = false;
+		for (size_t j = 0; j < _lb.size(); ++j)
+		{
+			if (_integer[j] && (_lb[j] == _ub[j] || !is_binary(_lb[j], _ub[j], _integer[j])))
+			{
+				if (!header)
+					writer << "Generals\n";
+				header = true;
+				writer << " " << variable_names[j] << "\n";
+			}
+		}
+
+		writer << "End\n";
+	}
+
+
+	void LinearModel::write_mps(std::ostream& out) const
+	{
+		ModelWriter writer(out);
+		const double infinity = std::numeric_limits<double>::infinity();
+		const std::vector<std::string> variable_names = generate_names(_variable_names);
+		const std::vector<std::string> row_names = generate_names(_rows.names);
+		const size_t nb_vars = _lb.size();
+
+		writer << "NAME RCPSP\nROWS\n N obj\n";
+		for (size_t r = 0; r < _rows.size(); ++r)
+		{
+			const double lb = _rows.lb[r], ub = _rows.ub[r];
+			const char* type = (lb == ub) ? " E " : (lb > -infinity) ? " G " : (ub < infinity) ? " L " : " N ";
+			writer << type << row_names[r] << "\n";
+		}
+
+		// the columns section is column-major: transpose the rows with a counting pass
+		std::vector<size_t> column_offsets(nb_vars + 1, 0);
+		for (int j : _rows.columns)
+			++column_offsets[j + 1];
+		for (size_t j = 0; j < nb_vars; ++j)
+			column_offsets[j + 1] += column_offsets[j];
+		std::vector<int> rows(_rows.columns.size());
+		std::vector<double> values(_rows.columns.size());
+		{
+			std::vector<size_t> next(column_offsets.begin(), column_offsets.end() - 1);
+			for (size_t r = 0; r < _rows.size(); ++r)
+			{
+				for (size_t e = _rows.offsets[r]; e < _rows.offsets[r + 1]; ++e)
+				{
+					size_t position = next[_rows.columns[e]]++;
+					rows[position] = static_cast<int>(r);
+					values[position] = _rows.values[e];
+				}
+			}
+		}
+
+		writer << "COLUMNS\n";
+		bool integer_section = false;
+		for (size_t j = 0; j < nb_vars; ++j)
+		{
+			if (_integer[j] != integer_section)
+			{
+				writer << (_integer[j] ? "    MARKER 'MARKER' 'INTORG'\n" : "    MARKER 'MARKER' 'INTEND'\n");
+				integer_section = _integer[j];
+			}
+
+			const std::string& name = variable_names[j];
+			if (_objective[j] != 0.0 || column_offsets[j] == column_offsets[j + 1])
+				writer << "    " << name << " obj " << _objective[j] << "\n";
+			for (size_t e = column_offsets[j]; e < column_offsets[j + 1]; ++e)
+				writer << "    " << name << " " << row_names[rows[e]] << " " << values[e] << "\n";
+		}
+		if (integer_section)
+			writer << "    MARKER 'MARKER' 'INTEND'\n";
+
+		writer << "RHS\n";
+		for (size_t r = 0; r < _rows.size(); ++r)
+		{
+			const double lb = _rows.lb[r], ub = _rows.ub[r];
+			double rhs = (lb > -infinity) ? lb : (ub < infinity) ? ub : 0.0;
+			if (rhs != 0.0)
+				writer << "    RHS " << row_names[r] << " " << rhs << "\n";
+		}
+
+		// G rows with a finite upper bound as well
+		bool header = false;
+		for (size_t r = 0; r < _rows.size(); ++r)
+		{
+			const double lb = _rows.lb[r], ub = _rows.ub[r];
+			if (lb > -infinity && ub < infinity && lb != ub)
+			{
+				if (!header)
+					writer << "RANGES\n";
+				header = true;
+				writer << "    RNG " << row_names[r] << " " << ub - lb << "\n";
+			}
+		}
+
+		// explicit bounds for every integer variable, since readers differ in the default upper bound of integer columns
+		writer << "BOUNDS\n";
+		for (size_t j = 0; j < nb_vars; ++j)
+		{
+			const std::string& name = variable_names[j];
+			const double lb = _lb[j], ub = _ub[j];
+			if (lb == ub)
+				writer << " FX BND " << name << " " << lb << "\n";
+			else if (lb == -infinity && ub == infinity)
+				writer << " FR BND " << name << "\n";
+			else
+			{
+				if (lb == -infinity)
+					writer << " MI BND " << name << "\n";
+				else if (lb != 0.0)
+					writer << " LO BND " << name << " " << lb << "\n";
+
+				if (ub < infinity)
+					writer << " UP BND " << name << " " << ub << "\n";
+				else if (_integer[j])
+					writer << " PL BND " << name << "\n";
+			}
+		}
+
+		writer << "ENDATA\n";
+	}
+
+
+	void LinearModel::write(const std::string& filename) const
+	{
+		const size_t dot = filename.find_last_of('.');
+		std::string extension = (dot == std::string::npos) ? "" : filename.substr(dot);
+		for (auto&& c : extension)
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		if (extension != ".lp" && extension != ".mps")
+		{
+			throw std::invalid_argument("Unknown model format for " + filename + " (use the extension .lp or .mps)");
+		}
+
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			throw std::invalid_argument("Couldn't create the file with name " + filename);
+		}
+
+		if (extension == ".lp")
+			write_lp(file);
+		else
+			write_mps(file);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef LINEAR_MODEL_RCPSP_H
+#define LINEAR_MODEL_RCPSP_H
+
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ortools/linear_solver/linear_solver.h"
+
+
+
+namespace RCPSP // resource-constrained project scheduling problem
+{
+	// Name of a variable or row: prefix, prefix_first, prefix_first_second or prefix_first_second_third
+	// Only the parts are stored; the text is generated when the model is exported
+	struct ModelName
+	{
+		const char* prefix = "";	// string literal
+		int first = -1;				// not used if negative
+		int second = -1;			// not used if negative
+		int third = -1;				// not used if negative
+
+		void append_to(std::string& out) const;
+		std::string str() const;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Sparse (mixed-integer) linear minimization model, stored row by row
+	// The IP formulations are built here first, then loaded into an OR-Tools solver and, on request,
+	// exported in LP or MPS format in time linear in the number of nonzeros
+	class LinearModel
+	{
+	public:
+		// Rows in compressed sparse row form: the terms of row r are columns/values[offsets[r] .. offsets[r+1])
+		// A block of rows can be assembled on its own, e.g. by another thread, and appended with add_rows
+		struct Rows
+		{
+			std::vector<double> lb;
+			std::vector<double> ub;
+			std::vector<ModelName> names;
+			std::vector<size_t> offsets{ 0 };
+			std::vector<int> columns;
+			std::vector<double> values;
+
+			int add(double row_lb, double row_ub, ModelName name); // starts a new row; returns its index in this block
+			void add_term(int column, double value) { columns.push_back(column); values.push_back(value); ++offsets.back(); }
+			void add_terms(const int* first_column, const double* first_value, size_t nb_terms); // appends to the last row
+
+			size_t size() const { return lb.size(); }
+			void reserve(size_t nb_rows, size_t nb_nonzeros);
+			void clear();
+		};
+
+	private:
+		// variables
+		std::vector<double> _lb;
+		std::vector<double> _ub;
+		std::vector<char> _integer;
+		std::vector<ModelName> _variable_names;
+		std::vector<double> _objective;			// [j] == objective coefficient of variable j
+
+		Rows _rows;
+
+	public:
+		int add_variable(double lb, double ub, bool integer, ModelName name); // returns the index of the variable
+		void set_bounds(int variable, double lb, double ub);
+		void set_objective(int variable, double coefficient);
+
+		int add_row(double lb, double ub, ModelName name) { return _rows.add(lb, ub, name); } // returns the index of the row
+		void add_term(int variable, double coefficient) { _rows.add_term(variable, coefficient); } // adds a term to the last row
+		void add_terms(const int* variables, const double* coefficients, size_t nb_terms) { _rows.add_terms(variables, coefficients, nb_terms); }
+		void add_rows(const Rows& rows); // appends a block of rows
+
+		int nb_variables() const { return static_cast<int>(_lb.size()); }
+		int nb_rows() const { return static_cast<int>(_rows.size()); }
+		size_t nb_nonzeros() const { return _rows.columns.size(); }
+		void reserve(size_t nb_variables, size_t nb_rows, size_t nb_nonzeros);
+		void clear();
+
+		// Create the (anonymous) variables and rows in the solver; returns the solver variable of every model variable
+		// The LP relaxation makes all variables continuous
+		std::vector<operations_research::MPVariable*> load(operations_research::MPSolver& solver, bool relaxation = false) const;
+
+		// Export in the CPLEX LP format or the free MPS format
+		void write_lp(std::ostream& out) const;
+		void write_mps(std::ostream& out) const;
+		void write(const std::string& filename) const; // format from the extension (.lp or .mps); throws if unknown
+	};
+}
+
+#endif // LINEAR_MODEL_RCPSP_H
@@ -1,4 +1,6 @@
 #include "algorithms.h"
+#include "batch.h"
+#include "server.h"
 #include "cxxopts.h"
 #include <iostream>
 #include <memory>
@@ -14,10 +16,41 @@ int main(int argc, char* argv[])
 
 		options.add_options()
 			("algorithm", "The choice of algorithm. Possibilities:"
-				"\n\t* \"IP\": an integer programming model solved with SCIP"
+				"\n\t* \"IP\": an integer programming model solved with the MIP solver chosen by --mip-solver (default SCIP)"
+				"\n\t* \"EventIP\": a continuous-time MIP with on/off event variables, whose size does not depend on the durations"
+				"\n\t* \"CPSAT\": a constraint programming model with interval variables and cumulative constraints solved with CP-SAT"
 				"\n\t* \"DH\": the branch-and-bound approach of Demeulemeester and Herroelen (1992)"
+				"\n\t* \"GA\": the genetic algorithm of Hartmann (1998) on activity lists, with the children of a generation decoded in parallel"
+				"\n\t* \"SA\": simulated annealing on activity lists with shift and swap moves, evaluated by decoding the changed part of the list only"
+				"\n\t* \"LNS\": large neighbourhood search that re-optimizes blocks of activities of the best schedule with DH or CP-SAT, in parallel"
+				"\n\t* \"Sampling\": multi-pass regret-based biased random sampling with the parallel and the serial SGS, spread over threads"
+				"\n\t* \"Portfolio\": DH, CP-SAT and SA race on their own threads with a shared best makespan; the first proof of optimality stops the others"
 				, cxxopts::value<std::string>())
-			("data", "Name of the file containing the problem data", cxxopts::value<std::string>())
+			("data", "Name of the file containing the problem data (Patterson/.rcp or PSPLIB .sm format, detected from the content)", cxxopts::value<std::string>())
+			("cache", "Read the data through the binary cache <data>.bin, which is created or refreshed when it is missing or stale", cxxopts::value<bool>())
+			("export-model", "Write the model of the IP or EventIP algorithm to this file, in LP (.lp) or free MPS (.mps) format", cxxopts::value<std::string>())
+			("mip-solver", "Backend of the IP and EventIP algorithms: SCIP (default), CBC, CP-SAT, GUROBI, CPLEX, ... as available in OR-Tools", cxxopts::value<std::string>())
+			("workers", "Number of parallel search workers of CP-SAT, threads of the MIP solver (also used to build the IP model) and threads of the GA, LNS and sampling (default: the solver default)", cxxopts::value<int>())
+			("gap", "Relative optimality gap at which CP-SAT and the MIP solver stop (e.g. 0.01)", cxxopts::value<double>())
+			("no-presolve", "Disable the presolve of CP-SAT and the MIP solver", cxxopts::value<bool>())
+			("formulation", "Precedence constraints of the IP: \"aggregated\" (default) or \"disaggregated\" (tighter LP relaxation, larger model)", cxxopts::value<std::string>())
+			("horizon-search", "Solve the IP as a sequence of feasibility problems on tightening horizons instead of one optimization", cxxopts::value<bool>())
+			("solver-params", "Solver specific parameters, in the format of the solver (e.g. \"num_workers:4,linearization_level:2\" for CP-SAT)", cxxopts::value<std::string>())
+			("seed", "Seed of the random number generators of the GA, SA, sampling and the DH restarts (default 0)", cxxopts::value<unsigned int>())
+			("schedules", "Maximum number of schedules generated by the GA (default 50000), moves of SA (default 200000) or passes of sampling (default 10000)", cxxopts::value<size_t>())
+			("justify", "Improve the final schedule, every schedule of the GA and every improving schedule of SA by double justification", cxxopts::value<bool>())
+			("beam-width", "Turn DH into a filtered beam search that expands only this many nodes per level of the tree, ranked by an SGS rollout (default 0: exact)", cxxopts::value<int>())
+			("rollouts", "Rank the delaying alternatives of DH of equal lower bound first by the makespan of an SGS rollout of their partial schedule", cxxopts::value<bool>())
+			("restarts", "Restart policy of DH on the number of nodes: \"none\" (default), \"luby\" or \"geometric\"", cxxopts::value<std::string>())
+			("restart-nodes", "Nodes of the first DH run before a restart, scaled for the next runs by the restart policy (default 1000)", cxxopts::value<size_t>())
+			("lns-repair", "Algorithm with which LNS re-optimizes a neighbourhood: \"DH\" (default) or \"CPSAT\"", cxxopts::value<std::string>())
+			("lns-size", "Number of activities of an LNS neighbourhood at the start (default 30), adapted to the repair times", cxxopts::value<int>())
+			("time-limit", "Maximum computation time in seconds (per instance in batch mode)", cxxopts::value<double>())
+			("batch", "Solve every instance in a directory, a glob pattern (e.g. \"j30/*.sm\") or a manifest file with one instance per line", cxxopts::value<std::string>())
+			("server", "Run as a solve server listening on the Unix domain socket with this path", cxxopts::value<std::string>())
+			("threads", "Number of instances solved in parallel in batch or server mode", cxxopts::value<int>())
+			("output-format", "Format of the result rows in batch mode: \"csv\" or \"jsonl\"", cxxopts::value<std::string>())
+			("output", "File for the result rows in batch mode (default: standard output)", cxxopts::value<std::string>())
 			("verbose", "Explain the various steps of the algorithm", cxxopts::value<bool>())
 			("help", "Help on how to use the application");
 
@@ -39,17 +72,104 @@ int main(int argc, char* argv[])
 		if (result.count("data"))
 			datafile = result["data"].as<std::string>();
 
+		bool use_cache = false;
+		if (result.count("cache"))
+			use_cache = result["cache"].as<bool>();
+
 		bool verbose = false;
 		if (result.count("verbose"))
 			verbose = result["verbose"].as<bool>();
 
+		double time_limit = 0;
+		if (result.count("time-limit"))
+			time_limit = result["time-limit"].as<double>();
+
+		RCPSP::SolverOptions solver_options;
+		if (result.count("mip-solver"))
+			solver_options.mip_solver = result["mip-solver"].as<std::string>();
+		if (result.count("workers"))
+			solver_options.nb_workers = std::max(result["workers"].as<int>(), 0);
+		if (result.count("gap"))
+			solver_options.relative_gap = result["gap"].as<double>();
+		if (result.count("no-presolve"))
+			solver_options.presolve = !result["no-presolve"].as<bool>();
+		if (result.count("formulation"))
+			solver_options.formulation = result["formulation"].as<std::string>();
+		if (result.count("horizon-search"))
+			solver_options.horizon_search = result["horizon-search"].as<bool>();
+		if (result.count("solver-params"))
+			solver_options.parameters = result["solver-params"].as<std::string>();
+		if (result.count("seed"))
+			solver_options.seed = result["seed"].as<unsigned int>();
+		if (result.count("schedules"))
+			solver_options.max_schedules = result["schedules"].as<size_t>();
+		if (result.count("justify"))
+			solver_options.justify = result["justify"].as<bool>();
+		if (result.count("beam-width"))
+			solver_options.beam_width = std::max(result["beam-width"].as<int>(), 0);
+		if (result.count("rollouts"))
+			solver_options.rollouts = result["rollouts"].as<bool>();
+		if (result.count("restarts"))
+			solver_options.restarts = result["restarts"].as<std::string>();
+		if (result.count("restart-nodes"))
+			solver_options.restart_nodes = std::max<size_t>(result["restart-nodes"].as<size_t>(), 1);
+		if (result.count("lns-repair"))
+			solver_options.lns_repair = result["lns-repair"].as<std::string>();
+		if (result.count("lns-size"))
+			solver_options.lns_size = std::max(result["lns-size"].as<int>(), 1);
+
+
+		// batch mode: solve many instances with a pool of threads
+		if (result.count("batch"))
+		{
+			RCPSP::BatchOptions batch;
+			batch.algorithm = algorithm;
+			batch.input = result["batch"].as<std::string>();
+			batch.max_time = time_limit;
+			batch.solver = solver_options;
+			batch.use_cache = use_cache;
+			if (result.count("threads"))
+				batch.nb_threads = result["threads"].as<int>();
+			if (result.count("output-format"))
+				batch.format = result["output-format"].as<std::string>();
+			if (result.count("output"))
+				batch.output = result["output"].as<std::string>();
+
+			RCPSP::run_batch(batch);
+			return EXIT_SUCCESS;
+		}
+
+
+
+
+		// server mode: solve the instances sent over a local socket until the process is stopped
+		if (result.count("server"))
+		{
+			RCPSP::ServerOptions server;
+			server.socket_path = result["server"].as<std::string>();
+			server.algorithm = algorithm;
+			server.max_time = time_limit;
+			server.solver = solver_options;
+			if (result.count("threads"))
+				server.nb_threads = result["threads"].as<int>();
+
+			RCPSP::run_server(server);
+			return EXIT_SUCCESS;
+		}
+
 
 
 
 		// create the algorithm and run it
 		std::unique_ptr<RCPSP::Algorithm> problem = RCPSP::AlgorithmFactory::create(algorithm);
-		problem->read_data(datafile);
+		if (time_limit > 0)
+			problem->set_max_time(time_limit);
+		problem->set_solver_options(solver_options);
+		if (result.count("export-model"))
+			problem->set_model_file(result["export-model"].as<std::string>());
+		problem->read_data(datafile, use_cache);
 		problem->run(verbose);
+		problem->justify();
 		problem->check_solution();
 
 
@@ -0,0 +1,501 @@
+#include "server.h"
+#include "algorithms.h"
+#include "json.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+
+namespace RCPSP
+{
+	namespace
+	{
+#ifdef _WIN32
+		typedef SOCKET socket_t;
+		const socket_t invalid_socket = INVALID_SOCKET;
+		void close_socket(socket_t s) { closesocket(s); }
+		int poll_sockets(pollfd* fds, size_t count) { return WSAPoll(fds, static_cast<ULONG>(count), -1); }
+		const int send_flags = 0;
+#else
+		typedef int socket_t;
+		const socket_t invalid_socket = -1;
+		void close_socket(socket_t s) { close(s); }
+		int poll_sockets(pollfd* fds, size_t count) { return poll(fds, static_cast<nfds_t>(count), -1); }
+#ifdef MSG_NOSIGNAL
+		const int send_flags = MSG_NOSIGNAL; // a client that disconnects should not kill the server
+#else
+		const int send_flags = 0;
+#endif
+#endif
+
+		const uint32_t max_message_size = 256u << 20;
+
+
+		bool write_exact(socket_t s, const char* buffer, size_t size)
+		{
+			while (size > 0)
+			{
+				int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+				int sent = send(s, buffer, chunk, send_flags);
+				if (sent <= 0)
+					return false;
+				buffer += sent;
+				size -= sent;
+			}
+			return true;
+		}
+
+
+		bool write_message(socket_t s, const std::string& message)
+		{
+			uint32_t size = static_cast<uint32_t>(message.size());
+			unsigned char prefix[4] = {
+				static_cast<unsigned char>(size), static_cast<unsigned char>(size >> 8),
+				static_cast<unsigned char>(size >> 16), static_cast<unsigned char>(size >> 24) };
+			return write_exact(s, reinterpret_cast<const char*>(prefix), sizeof(prefix))
+				&& write_exact(s, message.data(), message.size());
+		}
+
+
+		///////////////////////////////////////////////////////////////////////
+
+
+		// A client connection: the event loop reads its messages, the workers solve its requests one at a time and in order
+		struct Connection
+		{
+			socket_t socket;
+			std::string received;				// bytes of an incomplete message, only used by the event loop
+			std::deque<std::string> requests;	// complete requests that no worker has taken yet
+			bool busy = false;					// a worker is solving a request of the connection
+			bool closed = false;				// the event loop no longer reads from the connection
+
+			explicit Connection(socket_t s) : socket(s) {}
+		};
+
+
+		// Connections with a waiting request, in the order in which they became ready
+		// A connection is in the queue or with a worker while it has requests, so that its responses keep their order
+		// and an idle connection never occupies a worker
+		class RequestQueue
+		{
+			std::mutex _mutex;
+			std::condition_variable _ready_available;
+			std::queue<std::shared_ptr<Connection>> _ready;
+			bool _stop = false;
+
+		public:
+			void push(const std::shared_ptr<Connection>& connection, std::string request)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				connection->requests.push_back(std::move(request));
+				if (!connection->busy)
+				{
+					connection->busy = true;
+					_ready.push(connection);
+					_ready_available.notify_one();
+				}
+			}
+
+			// nullptr once the queue is stopped and empty
+			std::shared_ptr<Connection> pop(std::string& request)
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_ready_available.wait(lock, [this]() { return !_ready.empty() || _stop; });
+				if (_ready.empty())
+					return nullptr;
+
+				std::shared_ptr<Connection> connection = std::move(_ready.front());
+				_ready.pop();
+				request = std::move(connection->requests.front());
+				connection->requests.pop_front();
+				return connection;
+			}
+
+			// the worker has answered a request; the remaining requests are dropped when the response could not be sent
+			void done(const std::shared_ptr<Connection>& connection, bool delivered)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (!delivered)
+					connection->requests.clear();
+				if (!connection->requests.empty())
+				{
+					_ready.push(connection); // behind the other connections
+					_ready_available.notify_one();
+					return;
+				}
+				connection->busy = false;
+				if (connection->closed)
+					close_socket(connection->socket);
+			}
+
+			// the client has closed the connection; the socket stays open until the requests it already sent are answered
+			void close(const std::shared_ptr<Connection>& connection)
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				connection->closed = true;
+				if (!connection->busy)
+					close_socket(connection->socket);
+			}
+
+			void stop()
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+				_ready_available.notify_all();
+			}
+		};
+
+
+		// Read what is available on a connection that poll reported as readable and queue the complete messages
+		// false when the connection was closed or sent a message that is too large
+		bool receive(const std::shared_ptr<Connection>& connection, RequestQueue& queue)
+		{
+			char chunk[1 << 16];
+			int received = recv(connection->socket, chunk, sizeof(chunk), 0);
+			if (received <= 0)
+			{
+#ifndef _WIN32
+				if (received < 0 && errno == EINTR)
+					return true;
+#endif
+				return false;
+			}
+
+			std::string& buffer = connection->received;
+			buffer.append(chunk, received);
+			size_t pos = 0;
+			while (buffer.size() - pos >= 4)
+			{
+				const unsigned char* prefix = reinterpret_cast<const unsigned char*>(buffer.data() + pos);
+				uint32_t size = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (static_cast<uint32_t>(prefix[3]) << 24);
+				if (size > max_message_size)
+					return false;
+				if (buffer.size() - pos - 4 < size)
+					break;
+
+				queue.push(connection, buffer.substr(pos + 4, size));
+				pos += 4 + static_cast<size_t>(size);
+			}
+			buffer.erase(0, pos);
+			return true;
+		}
+
+
+		///////////////////////////////////////////////////////////////////////
+
+
+		// {"resources": [...], "activities": [{"duration": d, "requirements": [...], "successors": [...]}, ...]}
+		void instance_from_json(const JsonValue& value, Instance& instance)
+		{
+			const JsonValue* resources = value.find("resources");
+			const JsonValue* activities = value.find("activities");
+			if (resources == nullptr || resources->type != JsonValue::Type::Array
+				|| activities == nullptr || activities->type != JsonValue::Type::Array)
+			{
+				throw std::invalid_argument("The instance should contain the arrays \"resources\" and \"activities\"");
+			}
+
+			instance.clear();
+			instance.nb_resources = static_cast<int>(resources->array.size());
+			instance.nb_activities = static_cast<int>(activities->array.size());
+
+			for (auto&& av : resources->array)
+				instance.resource_availabilities.push_back(av.as_int("resource availability"));
+
+			instance.successor_offsets.push_back(0);
+			for (int i = 0; i < instance.nb_activities; ++i)
+			{
+				const JsonValue& act = activities->array[i];
+				const JsonValue* duration = act.find("duration");
+				const JsonValue* requirements = act.find("requirements");
+				const JsonValue* successors = act.find("successors");
+				if (duration == nullptr)
+				{
+					throw std::invalid_argument("Activity " + std::to_string(i + 1) + " has no duration");
+				}
+				instance.durations.push_back(duration->as_int("duration"));
+
+				size_t nb_requirements = (requirements != nullptr) ? requirements->array.size() : 0;
+				if (nb_requirements != static_cast<size_t>(instance.nb_resources))
+				{
+					throw std::invalid_argument("Activity " + std::to_string(i + 1) + " should have "
+						+ std::to_string(instance.nb_resources) + " resource requirements");
+				}
+				for (size_t k = 0; k < nb_requirements; ++k)
+					instance.requirements.push_back(requirements->array[k].as_int("resource requirement"));
+
+				if (successors != nullptr)
+				{
+					for (auto&& suc : successors->array)
+						instance.successors.push_back(suc.as_int("successor") - 1); // numbering starts at 1 instead of 0
+				}
+				instance.successor_offsets.push_back(static_cast<int>(instance.successors.size()));
+			}
+		}
+
+
+		std::string error_response(const std::string& msg)
+		{
+			return "{\"status\":\"error\",\"error\":" + json_quote(msg) + "}";
+		}
+
+
+		///////////////////////////////////////////////////////////////////////
+
+
+		// Serves connections; the algorithms of a worker are created on first use and reused afterwards
+		class Worker
+		{
+			const ServerOptions& _options;
+			std::map<std::string, std::unique_ptr<Algorithm>> _algorithms;
+			std::map<std::string, double> _default_max_time;
+
+			Algorithm& algorithm(std::string name)
+			{
+				std::transform(name.begin(), name.end(), name.begin(),
+					[](unsigned char c) { return std::tolower(c); });
+
+				auto it = _algorithms.find(name);
+				if (it == _algorithms.end())
+				{
+					std::string factory_name = name;
+					auto created = AlgorithmFactory::create(factory_name);
+					created->set_silent(true);
+					created->set_solver_options(_options.solver);
+					if (_options.max_time > 0)
+						created->set_max_time(_options.max_time);
+					_default_max_time[name] = created->max_time();
+					it = _algorithms.emplace(name, std::move(created)).first;
+				}
+
+				// every request starts from the default time limit
+				it->second->set_max_time(_default_max_time[name]);
+				return *it->second;
+			}
+
+			std::string solve(const std::string& request)
+			{
+				std::string algorithm_name = _options.algorithm;
+				double max_time = 0;
+				Instance instance;
+
+				size_t first = request.find_first_not_of(" \t\r\n");
+				if (first != std::string::npos && request[first] == '{')
+				{
+					JsonValue json = parse_json(request.data(), request.data() + request.size());
+					if (const JsonValue* value = json.find("algorithm"); value != nullptr && value->type == JsonValue::Type::String)
+						algorithm_name = value->string;
+					if (const JsonValue* value = json.find("time_limit"); value != nullptr && value->type == JsonValue::Type::Number)
+						max_time = value->number;
+
+					const JsonValue* data = json.find("instance");
+					if (data == nullptr)
+					{
+						throw std::invalid_argument("The request contains no instance");
+					}
+					if (data->type == JsonValue::Type::String)
+						parse_instance(data->string.data(), data->string.data() + data->string.size(), "request", instance);
+					else
+						instance_from_json(*data, instance);
+				}
+				else
+				{
+					parse_instance(request.data(), request.data() + request.size(), "request", instance);
+				}
+
+				// the data is checked before anything is derived from it, whatever the format; the predecessors and the
+				// preprocessing results of a binary payload come from the client, so they are computed again
+				instance.validate();
+				instance.build_predecessors();
+				instance.preprocess();
+
+				Algorithm& solver = algorithm(algorithm_name);
+				if (max_time > 0)
+					solver.set_max_time(max_time);
+
+				auto start_time = std::chrono::steady_clock::now();
+				solver.load_instance(instance);
+				solver.run(false);
+				solver.justify();
+				std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+				const std::vector<int>& finish_times = solver.finish_times();
+				if (finish_times.empty())
+				{
+					return "{\"status\":\"no_solution\",\"time\":" + std::to_string(elapsed_time.count())
+						+ ",\"nodes\":" + std::to_string(solver.nb_nodes()) + "}";
+				}
+
+				std::ostringstream response;
+				response << "{\"status\":\"" << (solver.optimal() ? "optimal" : "feasible") << "\""
+					<< ",\"makespan\":" << solver.makespan()
+					<< ",\"lower_bound\":" << solver.lower_bound()
+					<< ",\"valid\":" << (solver.check_solution() ? "true" : "false")
+					<< ",\"time\":" << elapsed_time.count()
+					<< ",\"nodes\":" << solver.nb_nodes()
+					<< ",\"start_times\":[";
+				for (size_t i = 0; i < finish_times.size(); ++i)
+					response << (i > 0 ? "," : "") << finish_times[i] - instance.durations[i];
+				response << "],\"finish_times\":[";
+				for (size_t i = 0; i < finish_times.size(); ++i)
+					response << (i > 0 ? "," : "") << finish_times[i];
+				response << "]}";
+				return response.str();
+			}
+
+		public:
+			explicit Worker(const ServerOptions& options) : _options(options) {}
+
+			std::string handle(const std::string& request)
+			{
+				try
+				{
+					return solve(request);
+				}
+				catch (const std::exception& e)
+				{
+					return error_response(e.what());
+				}
+			}
+		};
+	}
+
+
+	void run_server(const ServerOptions& options)
+	{
+#ifdef _WIN32
+		WSADATA wsa_data;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+		{
+			throw std::runtime_error("Couldn't initialize Winsock");
+		}
+#endif
+
+		// an unknown default algorithm should be reported before the server starts
+		{
+			std::string name = options.algorithm;
+			AlgorithmFactory::create(name);
+		}
+
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (options.socket_path.empty() || options.socket_path.size() >= sizeof(address.sun_path))
+		{
+			throw std::invalid_argument("Invalid socket path " + options.socket_path);
+		}
+		options.socket_path.copy(address.sun_path, options.socket_path.size());
+
+		socket_t listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener == invalid_socket)
+		{
+			throw std::runtime_error("Couldn't create a socket");
+		}
+
+		std::error_code ec;
+		std::filesystem::remove(options.socket_path, ec); // stale socket of a previous run
+		if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0)
+		{
+			close_socket(listener);
+			throw std::runtime_error("Couldn't listen on the socket " + options.socket_path);
+		}
+		std::cout << "\nListening on " << options.socket_path << " with " << std::max(options.nb_threads, 1) << " worker threads" << std::endl;
+
+		// the workers take requests from the queue, whatever connection they came from
+		RequestQueue queue;
+		std::vector<std::thread> workers;
+		for (int w = 0; w < std::max(options.nb_threads, 1); ++w)
+		{
+			workers.emplace_back([&]() {
+				Worker worker(options);
+				std::string request;
+				while (std::shared_ptr<Connection> connection = queue.pop(request))
+				{
+					const bool delivered = write_message(connection->socket, worker.handle(request));
+					queue.done(connection, delivered);
+				}
+			});
+		}
+
+		// event loop: accept connections and read the requests of all of them; fds[0] is the listener and
+		// fds[i + 1] belongs to connections[i]
+		std::vector<std::shared_ptr<Connection>> connections;
+		std::vector<pollfd> fds(1);
+		fds[0].fd = listener;
+		fds[0].events = POLLIN;
+		while (true)
+		{
+			if (poll_sockets(fds.data(), fds.size()) < 0)
+			{
+#ifndef _WIN32
+				if (errno == EINTR)
+					continue;
+#endif
+				break;
+			}
+
+			for (size_t i = connections.size(); i-- > 0; )
+			{
+				if (fds[i + 1].revents == 0 || receive(connections[i], queue))
+					continue;
+				queue.close(connections[i]);
+				connections.erase(connections.begin() + i);
+				fds.erase(fds.begin() + i + 1);
+			}
+
+			if (fds[0].revents & (POLLERR | POLLNVAL))
+				break;
+			if (fds[0].revents & POLLIN)
+			{
+				socket_t connection = accept(listener, nullptr, nullptr);
+				if (connection != invalid_socket)
+				{
+					connections.push_back(std::make_shared<Connection>(connection));
+					pollfd fd = {};
+					fd.fd = connection;
+					fd.events = POLLIN;
+					fds.push_back(fd);
+				}
+			}
+		}
+
+		// the listener failed: let the workers answer the queued requests and stop
+		queue.stop();
+		for (auto&& worker : workers)
+			worker.join();
+		for (auto&& connection : connections)
+			queue.close(connection);
+		close_socket(listener);
+		std::filesystem::remove(options.socket_path, ec);
+
+#ifdef _WIN32
+		WSACleanup();
+#endif
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef SERVER_RCPSP_H
+#define SERVER_RCPSP_H
+
+
+#include <string>
+#include "algorithms.h"
+
+
+
+namespace RCPSP // resource-constrained project scheduling problem
+{
+	// Long-running solve server on a Unix domain socket
+	//
+	// Every message (in both directions) is a 4-byte little-endian length followed by the payload.
+	// A request payload is either
+	//   - a JSON object {"algorithm": "DH", "time_limit": 10, "instance": ...} where the instance is the text of an
+	//     instance file or an object {"resources": [...], "activities": [{"duration": d, "requirements": [...],
+	//     "successors": [...]}, ...]} with successors numbered from 1 as in the data files, or
+	//   - the raw contents of an instance file (Patterson, PSPLIB .sm or binary cache), solved with the server defaults.
+	// The response is a JSON object with the status, the schedule and the statistics of the run.
+	// A connection can send any number of requests, which are answered in order. The requests of all connections are
+	// queued as they arrive and solved by a pool of worker threads, each of which keeps its algorithm objects alive across
+	// requests; an idle connection does not occupy a worker.
+	struct ServerOptions
+	{
+		std::string socket_path;
+		std::string algorithm;			// default algorithm for requests that do not specify one
+		int nb_threads = 1;
+		double max_time = 0;			// default time limit per request in seconds, 0 keeps the default of the algorithm
+		SolverOptions solver;			// options of the OR-Tools solvers
+	};
+
+	void run_server(const ServerOptions& options);
+}
+
+#endif // SERVER_RCPSP_H
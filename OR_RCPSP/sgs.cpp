@@ -0,0 +1,397 @@
+#include "sgs.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RCPSP_SGS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+
+namespace RCPSP
+{
+	void SGS::reset(const Instance& instance)
+	{
+		_instance = &instance;
+		_width = (instance.nb_resources + 3) / 4 * 4;
+
+		_requirements.assign(static_cast<size_t>(instance.nb_activities) * _width, 0);
+		_uses_resources.assign(instance.nb_activities, false);
+		size_t total_duration = 0;
+		for (int j = 0; j < instance.nb_activities; ++j)
+		{
+			total_duration += instance.durations[j];
+			for (int k = 0; k < instance.nb_resources; ++k)
+			{
+				const int requirement = instance.requirement(j, k);
+				if (requirement > instance.resource_availabilities[k])
+				{
+					throw std::invalid_argument("Activity " + std::to_string(j + 1) + " requires more of resource type "
+						+ std::to_string(k + 1) + " than is available");
+				}
+				_requirements[static_cast<size_t>(j) * _width + k] = requirement;
+				if (requirement > 0 && instance.durations[j] > 0)
+					_uses_resources[j] = true;
+			}
+		}
+
+		// no schedule of the serial SGS is longer than the sum of the durations
+		const size_t nb_periods = total_duration + 1;
+		_empty.assign(nb_periods * _width, 0);
+		for (size_t t = 0; t < nb_periods; ++t)
+			std::copy_n(instance.resource_availabilities.begin(), instance.nb_resources, _empty.begin() + t * _width);
+		_free = _empty;
+		_used_periods = 0;
+		_prefix_makespan.assign(instance.nb_activities + 1, 0);
+	}
+
+
+	void SGS::clear()
+	{
+		std::copy_n(_empty.begin(), static_cast<size_t>(_used_periods) * _width, _free.begin());
+		_used_periods = 0;
+	}
+
+
+	bool SGS::shortage(int t, const int* requirement) const
+	{
+		const int width = _width;
+		const int* free = _free.data() + static_cast<size_t>(t) * width;
+#ifdef RCPSP_SGS_SSE2
+		__m128i short_of = _mm_setzero_si128();
+		for (int k = 0; k < width; k += 4)
+		{
+			const __m128i capacity = _mm_loadu_si128(reinterpret_cast<const __m128i*>(free + k));
+			const __m128i required = _mm_loadu_si128(reinterpret_cast<const __m128i*>(requirement + k));
+			short_of = _mm_or_si128(short_of, _mm_cmplt_epi32(capacity, required));
+		}
+		return _mm_movemask_epi8(short_of) != 0;
+#else
+		bool short_of = false;
+		for (int k = 0; k < width; ++k)
+			short_of |= (free[k] < requirement[k]);
+		return short_of;
+#endif
+	}
+
+
+	int SGS::feasible_start(int activity, int earliest_start) const
+	{
+		if (!_uses_resources[activity])
+			return earliest_start;
+
+		// check the periods of the activity from the last to the first: a shortage in period t rules out every start
+		// up to t, so the next candidate start is t + 1
+		const int duration = _instance->durations[activity];
+		const int* requirement = _requirements.data() + static_cast<size_t>(activity) * _width;
+		int start = earliest_start;
+		int checked = start; // the periods [start, checked) are known to be free
+		for (int t = start + duration - 1; t >= checked; )
+		{
+			if (shortage(t, requirement))
+			{
+				checked = std::max(checked, start + duration);
+				start = t + 1;
+				t = start + duration - 1;
+			}
+			else
+			{
+				--t;
+			}
+		}
+		return start;
+	}
+
+
+	void SGS::reserve(int activity, int start, int finish)
+	{
+		const int width = _width; // a local copy, the stores to the profile could otherwise alias _width
+		const int* requirement = _requirements.data() + static_cast<size_t>(activity) * width;
+		int* free = _free.data() + static_cast<size_t>(start) * width;
+		int* last = _free.data() + static_cast<size_t>(finish) * width;
+#ifdef RCPSP_SGS_SSE2
+		for (; free != last; free += width)
+		{
+			for (int k = 0; k < width; k += 4)
+			{
+				const __m128i capacity = _mm_loadu_si128(reinterpret_cast<const __m128i*>(free + k));
+				const __m128i required = _mm_loadu_si128(reinterpret_cast<const __m128i*>(requirement + k));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(free + k), _mm_sub_epi32(capacity, required));
+			}
+		}
+#else
+		for (; free != last; free += width)
+			for (int k = 0; k < width; ++k)
+				free[k] -= requirement[k];
+#endif
+	}
+
+
+	void SGS::release(int activity, int start, int finish)
+	{
+		const int width = _width;
+		const int* requirement = _requirements.data() + static_cast<size_t>(activity) * width;
+		int* free = _free.data() + static_cast<size_t>(start) * width;
+		int* last = _free.data() + static_cast<size_t>(finish) * width;
+#ifdef RCPSP_SGS_SSE2
+		for (; free != last; free += width)
+		{
+			for (int k = 0; k < width; k += 4)
+			{
+				const __m128i capacity = _mm_loadu_si128(reinterpret_cast<const __m128i*>(free + k));
+				const __m128i required = _mm_loadu_si128(reinterpret_cast<const __m128i*>(requirement + k));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(free + k), _mm_add_epi32(capacity, required));
+			}
+		}
+#else
+		for (; free != last; free += width)
+			for (int k = 0; k < width; ++k)
+				free[k] += requirement[k];
+#endif
+	}
+
+
+	int SGS::schedule(const int* activity_list, int* finish_times, int position)
+	{
+		int makespan = _prefix_makespan[position];
+		for (int n = position; n < _instance->nb_activities; ++n)
+		{
+			const int j = activity_list[n];
+
+			int earliest_start = 0;
+			for (const int* pred = _instance->predecessors_begin(j); pred != _instance->predecessors_end(j); ++pred)
+				earliest_start = std::max(earliest_start, finish_times[*pred]);
+
+			const int start = feasible_start(j, earliest_start);
+			const int finish = start + _instance->durations[j];
+			if (_uses_resources[j])
+				reserve(j, start, finish);
+
+			finish_times[j] = finish;
+			makespan = std::max(makespan, finish);
+			_prefix_makespan[n + 1] = makespan;
+		}
+
+		_used_periods = std::max(_used_periods, makespan);
+		return makespan;
+	}
+
+
+	int SGS::decode(const int* activity_list, int* finish_times)
+	{
+		clear();
+		return schedule(activity_list, finish_times, 0);
+	}
+
+
+	int SGS::decode(const int* activity_list, int* finish_times, int position)
+	{
+		// take the activities from position on, as scheduled by the previous decode, from the profile
+		for (int n = position; n < _instance->nb_activities; ++n)
+		{
+			const int j = activity_list[n];
+			if (_uses_resources[j])
+				release(j, finish_times[j] - _instance->durations[j], finish_times[j]);
+		}
+		return schedule(activity_list, finish_times, position);
+	}
+
+
+	int SGS::decode(const std::vector<int>& activity_list, std::vector<int>& finish_times)
+	{
+		if (static_cast<int>(activity_list.size()) != _instance->nb_activities)
+		{
+			throw std::invalid_argument("The activity list does not contain every activity once");
+		}
+		finish_times.resize(_instance->nb_activities);
+		return decode(activity_list.data(), finish_times.data());
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	void ParallelSGS::reset(const Instance& instance)
+	{
+		_instance = &instance;
+		_profile.reset(instance);
+		_nb_unscheduled_predecessors.resize(instance.nb_activities);
+		_earliest_start.resize(instance.nb_activities);
+		_ready.reserve(instance.nb_activities);
+		_in_progress.reserve(instance.nb_activities);
+		_decision_set.reserve(instance.nb_activities);
+	}
+
+
+	bool ParallelSGS::fits(int activity, int start) const
+	{
+		if (!_profile._uses_resources[activity])
+			return true;
+		const int* requirement = _profile._requirements.data() + static_cast<size_t>(activity) * _profile._width;
+		for (int t = start; t < start + _instance->durations[activity]; ++t)
+			if (_profile.shortage(t, requirement))
+				return false;
+		return true;
+	}
+
+
+	void ParallelSGS::start(int activity, int start, int* finish_times)
+	{
+		const int finish = start + _instance->durations[activity];
+		if (_profile._uses_resources[activity])
+			_profile.reserve(activity, start, finish);
+		finish_times[activity] = finish;
+		if (finish > start)
+			_in_progress.push_back(finish);
+
+		for (const int* suc = _instance->successors_begin(activity); suc != _instance->successors_end(activity); ++suc)
+		{
+			_earliest_start[*suc] = std::max(_earliest_start[*suc], finish);
+			if (--_nb_unscheduled_predecessors[*suc] == 0)
+				_ready.push_back(*suc);
+		}
+	}
+
+
+	int ParallelSGS::sample(const int* priorities, std::mt19937_64& rng, int* finish_times)
+	{
+		const int nb_activities = _instance->nb_activities;
+		_profile.clear();
+		_ready.clear();
+		_in_progress.clear();
+		for (int j = 0; j < nb_activities; ++j)
+		{
+			_nb_unscheduled_predecessors[j] = _instance->predecessor_offsets[j + 1] - _instance->predecessor_offsets[j];
+			_earliest_start[j] = 0;
+			if (_nb_unscheduled_predecessors[j] == 0)
+				_ready.push_back(j);
+		}
+
+		// without activities in progress every eligible activity fits, so the schedule has no idle periods and is not
+		// longer than the sum of the durations, which the profile covers
+		int time = 0, makespan = 0;
+		for (int nb_scheduled = 0; nb_scheduled < nb_activities; )
+		{
+			for (;;)
+			{
+				_decision_set.clear();
+				int max_priority = std::numeric_limits<int>::min();
+				for (int r = 0; r < static_cast<int>(_ready.size()); ++r)
+				{
+					if (_earliest_start[_ready[r]] <= time && fits(_ready[r], time))
+					{
+						_decision_set.push_back(r);
+						max_priority = std::max(max_priority, priorities[_ready[r]]);
+					}
+				}
+				if (_decision_set.empty())
+					break;
+
+				int64_t total_weight = 0;
+				for (int r : _decision_set)
+					total_weight += static_cast<int64_t>(max_priority) - priorities[_ready[r]] + 1;
+				int64_t draw = std::uniform_int_distribution<int64_t>(0, total_weight - 1)(rng);
+				size_t d = 0;
+				for (; draw >= static_cast<int64_t>(max_priority) - priorities[_ready[_decision_set[d]]] + 1; ++d)
+					draw -= static_cast<int64_t>(max_priority) - priorities[_ready[_decision_set[d]]] + 1;
+
+				const int j = _ready[_decision_set[d]];
+				_ready[_decision_set[d]] = _ready.back();
+				_ready.pop_back();
+				start(j, time, finish_times);
+				makespan = std::max(makespan, finish_times[j]);
+				++nb_scheduled;
+			}
+
+			// next decision time: the first finish of an activity in progress
+			int next = std::numeric_limits<int>::max();
+			for (int finish : _in_progress)
+				next = std::min(next, finish);
+			if (next == std::numeric_limits<int>::max())
+				break;
+			time = next;
+			_in_progress.erase(std::remove_if(_in_progress.begin(), _in_progress.end(), [time](int finish) { return finish <= time; }),
+				_in_progress.end());
+		}
+
+		_profile._used_periods = std::max(_profile._used_periods, makespan);
+		return makespan;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////
+
+
+	void Justification::reset(const Instance& instance)
+	{
+		_instance = &instance;
+
+		_reversed.nb_activities = instance.nb_activities;
+		_reversed.nb_resources = instance.nb_resources;
+		_reversed.resource_availabilities = instance.resource_availabilities;
+		_reversed.durations = instance.durations;
+		_reversed.requirements = instance.requirements;
+		_reversed.successor_offsets = instance.predecessor_offsets;
+		_reversed.successors = instance.predecessors;
+		_reversed.predecessor_offsets = instance.successor_offsets;
+		_reversed.predecessors = instance.successors;
+
+		_forward.reset(instance);
+		_backward.reset(_reversed);
+
+		// topological order (Kahn)
+		const int nb_activities = instance.nb_activities;
+		std::vector<int> nb_predecessors(nb_activities);
+		_topological.clear();
+		for (int i = 0; i < nb_activities; ++i)
+		{
+			nb_predecessors[i] = instance.predecessor_offsets[i + 1] - instance.predecessor_offsets[i];
+			if (nb_predecessors[i] == 0)
+				_topological.push_back(i);
+		}
+		for (size_t n = 0; n < _topological.size(); ++n)
+			for (const int* suc = instance.successors_begin(_topological[n]); suc != instance.successors_end(_topological[n]); ++suc)
+				if (--nb_predecessors[*suc] == 0)
+					_topological.push_back(*suc);
+		if (static_cast<int>(_topological.size()) != nb_activities)
+		{
+			throw std::invalid_argument("The precedence relations contain a cycle");
+		}
+
+		_list.resize(nb_activities);
+		_times.resize(nb_activities);
+	}
+
+
+	int Justification::improve(int* finish_times, int* activity_list)
+	{
+		const int nb_activities = _instance->nb_activities;
+		int makespan = 0;
+		for (int j = 0; j < nb_activities; ++j)
+			makespan = std::max(makespan, finish_times[j]);
+
+		// right justification: in the reversed project an activity starts at makespan - finish time; a stable sort of a
+		// topological order keeps the list precedence feasible when activities without duration tie
+		std::copy(_topological.rbegin(), _topological.rend(), _list.begin());
+		std::stable_sort(_list.begin(), _list.end(), [finish_times](int a, int b) { return finish_times[a] > finish_times[b]; });
+		const int right_makespan = _backward.decode(_list.data(), _times.data());
+		for (int j = 0; j < nb_activities; ++j)
+			_times[j] = right_makespan - _times[j]; // start time of j in the right justified schedule
+
+		// left justification
+		std::copy(_topological.begin(), _topological.end(), _list.begin());
+		std::stable_sort(_list.begin(), _list.end(), [this](int a, int b) { return _times[a] < _times[b]; });
+		const int left_makespan = _forward.decode(_list.data(), _times.data());
+		if (left_makespan > makespan)
+			return makespan; // does not happen for a feasible schedule, which each pass can only shorten
+
+		std::copy(_times.begin(), _times.end(), finish_times);
+		if (activity_list)
+			std::copy(_list.begin(), _list.end(), activity_list);
+		return left_makespan;
+	}
+}
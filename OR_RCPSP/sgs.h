@@ -0,0 +1,120 @@
+#pragma once
+#ifndef SGS_RCPSP_H
+#define SGS_RCPSP_H
+
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "instance.h"
+
+
+
+namespace RCPSP // resource-constrained project scheduling problem
+{
+	// Serial schedule generation scheme: decodes an activity list into a schedule by starting the activities one by one,
+	// in list order, at their earliest precedence and resource feasible time
+	//
+	// The resource profile is flat and time-bucketed: the free capacities of all resource types in period t are
+	// _free[t * _width .. t * _width + nb_resources), padded to a multiple of 4 so that one SSE2 comparison (when available)
+	// checks 4 resource types of a period at once. The profile is restored with one bulk copy per decode.
+	// All buffers are allocated by reset() and reused by every decode, which does not allocate.
+	// An SGS object decodes for one thread at a time; give every thread its own copy.
+	class SGS
+	{
+		const Instance* _instance = nullptr;
+
+		int _width = 0;					// resource types per period in _free and _requirements, padded to a multiple of 4
+		std::vector<int> _free;			// [t * _width + k] == free capacity of resource type k in period t
+		std::vector<int> _empty;		// _free without any activity: the availabilities in every period, 0 for the padding
+		int _used_periods = 0;			// periods of _free changed by the last decode
+		std::vector<int> _requirements;	// [j * _width + k] == requirement of activity j for resource type k, 0 for the padding
+		std::vector<char> _uses_resources; // [j] == true if activity j has a positive duration and requires some resource
+		std::vector<int> _prefix_makespan; // [n] == makespan of the first n activities of the list of the last decode
+
+		void clear(); // restore the profile of the periods used since the last complete decode
+		bool shortage(int t, const int* requirement) const; // true if period t cannot take the requirement
+		int feasible_start(int activity, int earliest_start) const; // earliest resource feasible start at or after earliest_start
+		void reserve(int activity, int start, int finish); // take the requirements of the activity from the profile
+		void release(int activity, int start, int finish); // give them back
+		int schedule(const int* activity_list, int* finish_times, int position); // the activities from position on
+
+		friend class ParallelSGS; // schedules on the same profile
+
+	public:
+		SGS() = default;
+		explicit SGS(const Instance& instance) { reset(instance); }
+
+		// Prepare the buffers for an instance, which must outlive the decodes; throws if an activity requires more of a
+		// resource type than is available
+		void reset(const Instance& instance);
+
+		// Decode a precedence feasible activity list (every activity after its predecessors) into the finish times of
+		// the activities; returns the makespan
+		int decode(const int* activity_list, int* finish_times);
+		int decode(const std::vector<int>& activity_list, std::vector<int>& finish_times);
+
+		// Decode again from position on, e.g. after a move in a local search: the activities before position must be those
+		// of the list of the previous decode, in the same order, and finish_times the result of that decode. Only the
+		// activities from position on are taken from the profile and scheduled again.
+		int decode(const int* activity_list, int* finish_times, int position);
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Parallel schedule generation scheme (Kelley, 1963): moves over the decision times, the finish times of the activities
+	// in progress, and at every decision time starts eligible activities that fit in the resource profile one at a time,
+	// until none fits; it generates non-delay schedules. Uses the profile of the serial SGS, with the same rules.
+	class ParallelSGS
+	{
+		const Instance* _instance = nullptr;
+		SGS _profile;
+		std::vector<int> _nb_unscheduled_predecessors;
+		std::vector<int> _earliest_start;	// [j] == latest finish time of the scheduled predecessors of j
+		std::vector<int> _ready;			// unscheduled activities of which all predecessors are scheduled
+		std::vector<int> _in_progress;		// finish times of the activities that finish after the decision time
+		std::vector<int> _decision_set;		// positions in _ready of the activities that can start at the decision time
+
+		bool fits(int activity, int start) const;
+		void start(int activity, int start, int* finish_times);
+
+	public:
+		ParallelSGS() = default;
+		explicit ParallelSGS(const Instance& instance) { reset(instance); }
+
+		void reset(const Instance& instance);
+
+		// Schedule the project, choosing among the activities that can start at a decision time by regret-based biased
+		// random sampling (Drexl, 1991) on priority values, lower first: j is chosen with a probability proportional to
+		// max_i p_i - p_j + 1 over these activities i; returns the makespan
+		int sample(const int* priorities, std::mt19937_64& rng, int* finish_times);
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	// Double justification (Valls et al., 2005): shift the activities as far right as possible in order of decreasing
+	// finish time, with the serial SGS on the project with reversed precedence relations, and then as far left as
+	// possible in order of increasing start time; the makespan never increases
+	class Justification
+	{
+		const Instance* _instance = nullptr;
+		Instance _reversed;				// successors and predecessors swapped
+		SGS _forward;
+		SGS _backward;
+		std::vector<int> _topological;	// activities in a topological order of the project, which breaks the ties of the sorts
+		std::vector<int> _list;
+		std::vector<int> _times;
+
+	public:
+		Justification() = default;
+		explicit Justification(const Instance& instance) { reset(instance); }
+
+		void reset(const Instance& instance);
+
+		// Justify the schedule with these finish times in place and return its makespan; activity_list, if given,
+		// receives the list that the serial SGS decodes into the justified schedule
+		int improve(int* finish_times, int* activity_list = nullptr);
+	};
+}
+
+#endif // SGS_RCPSP_H